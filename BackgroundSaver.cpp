@@ -0,0 +1,115 @@
+#include "BackgroundSaver.h"
+#include <QThread>
+
+BackgroundSaver::BackgroundSaver(int delayMs, QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(delayMs);
+    connect(&m_timer, &QTimer::timeout, this, [this]() { startNext(); });
+}
+
+BackgroundSaver::~BackgroundSaver()
+{
+    flush();
+}
+
+void BackgroundSaver::setDelay(int delayMs)
+{
+    m_timer.setInterval(delayMs);
+}
+
+void BackgroundSaver::schedule(const std::string &target, Contacts contacts,
+                               Writer writer, Done done)
+{
+    for (auto &job : m_jobs)
+    {
+        if (job.target == target)
+        {
+            // ещё не записан — просто берём более свежий снимок
+            job.contacts = std::move(contacts);
+            job.writer   = std::move(writer);
+            job.done     = std::move(done);
+            return;
+        }
+    }
+
+    m_jobs.push_back(Job{target, std::move(contacts), std::move(writer), std::move(done)});
+
+    // окно отсчитывается от первого запроса, чтобы серия правок не откладывала запись бесконечно
+    if (!m_thread && !m_timer.isActive())
+        m_timer.start();
+}
+
+bool BackgroundSaver::hasPending(const std::string &target) const
+{
+    if (m_current && m_current->target == target)
+        return true;
+    for (const auto &job : m_jobs)
+    {
+        if (job.target == target)
+            return true;
+    }
+    return false;
+}
+
+void BackgroundSaver::startNext()
+{
+    if (m_thread || m_jobs.empty())
+        return;
+
+    m_current = std::make_shared<Job>(std::move(m_jobs.front()));
+    m_jobs.erase(m_jobs.begin());
+    m_currentOk = std::make_shared<bool>(false);
+
+    m_thread = QThread::create([job = m_current, ok = m_currentOk]()
+    {
+        *ok = job->writer(*job->contacts);
+    });
+
+    connect(m_thread, &QThread::finished, this, [this]()
+    {
+        m_thread->deleteLater();
+        m_thread = nullptr;
+        finishCurrent();
+
+        // запросы, пришедшие во время записи, тоже выжидают окно
+        if (!m_jobs.empty() && !m_thread && !m_timer.isActive())
+            m_timer.start();
+    });
+
+    m_thread->start();
+}
+
+void BackgroundSaver::finishCurrent()
+{
+    auto job = std::move(m_current);
+    auto ok = std::move(m_currentOk);
+    if (job && job->done)
+        job->done(*ok);
+}
+
+void BackgroundSaver::flush()
+{
+    m_timer.stop();
+
+    if (m_thread)
+    {
+        // сигнал finished уже не дойдёт — завершаем запись здесь
+        m_thread->disconnect(this);
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+        finishCurrent();
+    }
+
+    while (!m_jobs.empty())
+    {
+        Job job = std::move(m_jobs.front());
+        m_jobs.erase(m_jobs.begin());
+
+        bool ok = job.writer(*job.contacts);
+        if (job.done)
+            job.done(ok);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Contact.h"
+
+class QThread;
+
+// Фоновая запись справочника.
+//
+// Запись получает неизменяемый снимок контактов и выполняется в рабочем потоке,
+// GUI-поток не ждёт диска. Запросы к одному и тому же файлу, пришедшие в пределах
+// окна задержки (или пока идёт предыдущая запись), сливаются в одну запись
+// последнего снимка. Разные файлы пишутся строго по очереди, в порядке запросов.
+class BackgroundSaver : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Contacts = std::shared_ptr<const std::vector<Contact>>;
+    using Writer   = std::function<bool(const std::vector<Contact>&)>;
+    using Done     = std::function<void(bool ok)>;
+
+    explicit BackgroundSaver(int delayMs = 500, QObject *parent = nullptr);
+    ~BackgroundSaver();
+
+    void setDelay(int delayMs);
+
+    // writer вызывается в рабочем потоке, done — в потоке объекта после записи
+    void schedule(const std::string &target, Contacts contacts, Writer writer, Done done = {});
+
+    bool hasPending(const std::string &target) const;
+    bool isIdle() const { return !m_thread && m_jobs.empty(); }
+
+    // Дождаться текущей записи и выполнить оставшиеся синхронно
+    void flush();
+
+private:
+    struct Job
+    {
+        std::string target;
+        Contacts    contacts;
+        Writer      writer;
+        Done        done;
+    };
+
+    void startNext();
+    void finishCurrent();
+
+    QTimer           m_timer;
+    QThread         *m_thread = nullptr;
+    std::vector<Job> m_jobs;
+
+    // запись, идущая сейчас в m_thread
+    std::shared_ptr<Job>  m_current;
+    std::shared_ptr<bool> m_currentOk;
+};
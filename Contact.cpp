@@ -1,4 +1,5 @@
 #include "Contact.h"
+#include "StringPool.h"
 #include <iostream>
 
 Contact::Contact(std::string lastName,
@@ -21,19 +22,32 @@ void Contact::addPhone(const PhoneNumber& p)
     m_phones.push_back(p);
 }
 
+void Contact::addPhone(PhoneNumber&& p)
+{
+    m_phones.push_back(std::move(p));
+}
+
 void Contact::clearPhones()
 {
     m_phones.clear();
 }
 
+void Contact::intern(StringPool& pool)
+{
+    m_lastName   = pool.intern(m_lastName);
+    m_firstName  = pool.intern(m_firstName);
+    m_middleName = pool.intern(m_middleName);
+    m_address    = pool.intern(m_address);
+}
+
 void Contact::print(int index) const
 {
     std::cout << "----------------------------------------\n";
     std::cout << "#" << index << "\n";
-    std::cout << "Фамилия:       " << m_lastName  << "\n";
-    std::cout << "Имя:           " << m_firstName << "\n";
-    std::cout << "Отчество:      " << m_middleName<< "\n";
-    std::cout << "Адрес:         " << m_address   << "\n";
+    std::cout << "Фамилия:       " << lastName()  << "\n";
+    std::cout << "Имя:           " << firstName() << "\n";
+    std::cout << "Отчество:      " << middleName()<< "\n";
+    std::cout << "Адрес:         " << address()   << "\n";
     std::cout << "Дата рождения: " << m_birthDate.toString() << "\n";
     std::cout << "E-mail:        " << m_email     << "\n";
     std::cout << "Телефоны:\n";
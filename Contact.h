@@ -1,8 +1,14 @@
 #pragma once
 #include <string>
-#include <vector>
 #include "Date.h"
 #include "PhoneNumber.h"
+#include "SharedString.h"
+#include "SmallVector.h"
+
+class StringPool;
+
+// До трёх телефонов — внутри контакта, без кучи
+using PhoneList = SmallVector<PhoneNumber, 3>;
 
 class Contact
 {
@@ -16,32 +22,42 @@ public:
             Date        birthDate,
             std::string email);
 
-    const std::string& lastName() const  { return m_lastName; }
-    const std::string& firstName() const { return m_firstName; }
-    const std::string& middleName() const{ return m_middleName; }
-    const std::string& address() const   { return m_address; }
+    const std::string& lastName() const  { return m_lastName.str(); }
+    const std::string& firstName() const { return m_firstName.str(); }
+    const std::string& middleName() const{ return m_middleName.str(); }
+    const std::string& address() const   { return m_address.str(); }
     const Date&        birthDate() const { return m_birthDate; }
     const std::string& email() const     { return m_email; }
-    const std::vector<PhoneNumber>& phones() const { return m_phones; }
+    const PhoneList&   phones() const { return m_phones; }
 
-    void setLastName(const std::string& v)  { m_lastName  = v; }
-    void setFirstName(const std::string& v) { m_firstName = v; }
-    void setMiddleName(const std::string& v){ m_middleName= v; }
-    void setAddress(const std::string& v)   { m_address   = v; }
+    void setLastName(const std::string& v)  { m_lastName  = SharedString(v); }
+    void setFirstName(const std::string& v) { m_firstName = SharedString(v); }
+    void setMiddleName(const std::string& v){ m_middleName= SharedString(v); }
+    void setAddress(const std::string& v)   { m_address   = SharedString(v); }
     void setBirthDate(const Date& d)        { m_birthDate = d; }
     void setEmail(const std::string& v)     { m_email     = v; }
 
+    void setLastName(SharedString v)  { m_lastName  = std::move(v); }
+    void setFirstName(SharedString v) { m_firstName = std::move(v); }
+    void setMiddleName(SharedString v){ m_middleName= std::move(v); }
+    void setAddress(SharedString v)   { m_address   = std::move(v); }
+
     void addPhone(const PhoneNumber& p);
+    void addPhone(PhoneNumber&& p);
     void clearPhones();
 
+    // Заменить ФИО и адрес значениями из пула (e-mail и телефоны у всех разные —
+    // их интернирование только добавило бы расходов)
+    void intern(StringPool& pool);
+
     void print(int index) const;
 
 private:
-    std::string m_lastName;
-    std::string m_firstName;
-    std::string m_middleName;
-    std::string m_address;
-    Date        m_birthDate;
-    std::string m_email;
-    std::vector<PhoneNumber> m_phones;
+    SharedString m_lastName;
+    SharedString m_firstName;
+    SharedString m_middleName;
+    SharedString m_address;
+    Date         m_birthDate;
+    std::string  m_email;
+    PhoneList    m_phones;
 };
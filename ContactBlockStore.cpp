@@ -0,0 +1,280 @@
+#include "ContactBlockStore.h"
+#include "ContactParser.h"
+#include "LzCodec.h"
+#include <algorithm>
+#include <cstring>
+#include <QSaveFile>
+#include <QString>
+
+namespace {
+
+const char kMagic[8] = { 'P', 'B', 'B', 'L', 'O', 'C', 'K', '\0' };
+const std::uint32_t kByteOrderMark = 0x01020304;
+
+struct Header
+{
+    char          magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t blockCount;
+    std::uint32_t reserved;
+    std::uint64_t indexOffset;
+    std::uint64_t indexSize;
+};
+
+static_assert(sizeof(Header) == 40, "block store header layout");
+
+// Запись индекса без строк: смещение, два размера, число контактов, две длины
+constexpr std::size_t kMinIndexEntry = 8 + 4 + 4 + 4 + 4 + 4;
+
+// LzCodec разворачивает байт сжатых данных самое большее в 255 байт
+// (байт продолжения длины совпадения)
+constexpr std::uint64_t kMaxExpansion = 255;
+
+// Запись контакта не короче строки «CONTACT\n» — граница contactCount для loadAll()
+constexpr std::uint32_t kMinRecord = 8;
+
+template <typename T>
+void put(std::string& out, T v)
+{
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void putString(std::string& out, const std::string& s)
+{
+    put(out, static_cast<std::uint32_t>(s.size()));
+    out += s;
+}
+
+template <typename T>
+bool get(const char*& p, const char* end, T& v)
+{
+    if (static_cast<std::size_t>(end - p) < sizeof(v))
+        return false;
+    std::memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return true;
+}
+
+bool getString(const char*& p, const char* end, std::string& s)
+{
+    std::uint32_t len = 0;
+    if (!get(p, end, len) || static_cast<std::size_t>(end - p) < len)
+        return false;
+    s.assign(p, len);
+    p += len;
+    return true;
+}
+
+} // namespace
+
+bool ContactBlockStore::save(const std::vector<Contact>& contacts, const std::string& fileName,
+                             std::size_t blockBytes)
+{
+    // порядок по фамилии — у блоков получаются непересекающиеся диапазоны ключей
+    std::vector<const Contact*> order;
+    order.reserve(contacts.size());
+    for (const auto& c : contacts)
+        order.push_back(&c);
+    std::stable_sort(order.begin(), order.end(), [](const Contact* a, const Contact* b)
+    {
+        return a->lastName() < b->lastName();
+    });
+
+    QSaveFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    auto write = [&](const std::string& bytes)
+    {
+        const qint64 n = static_cast<qint64>(bytes.size());
+        return file.write(bytes.data(), n) == n;
+    };
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.byteOrder = kByteOrderMark;
+    h.version   = kVersion;
+
+    // заголовок перезаписывается в конце, когда известны смещение и размер индекса
+    if (!write(std::string(sizeof(Header), '\0')))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    std::string raw;
+    std::string packed;
+    std::string index;
+    std::uint64_t offset = sizeof(Header);
+    std::size_t blockStart = 0;
+
+    // блок режется по записям и может выйти за blockBytes на одну запись
+    blockBytes = std::min(blockBytes, kMaxBlockBytes / 2);
+
+    auto flushBlock = [&](std::size_t blockEnd)
+    {
+        if (raw.size() > kMaxBlockBytes)
+            return false; // одна запись больше предела — open() такой блок не примет
+
+        packed.clear();
+        LzCodec::compress(raw.data(), raw.size(), packed);
+
+        put(index, offset);
+        put(index, static_cast<std::uint32_t>(packed.size()));
+        put(index, static_cast<std::uint32_t>(raw.size()));
+        put(index, static_cast<std::uint32_t>(blockEnd - blockStart));
+        putString(index, order[blockStart]->lastName());
+        putString(index, order[blockEnd - 1]->lastName());
+
+        offset += packed.size();
+        ++h.blockCount;
+        raw.clear();
+        blockStart = blockEnd;
+        return write(packed);
+    };
+
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        ContactParser::appendRecord(raw, *order[i]);
+        if (raw.size() >= blockBytes && !flushBlock(i + 1))
+        {
+            file.cancelWriting();
+            return false;
+        }
+    }
+
+    if (!raw.empty() && !flushBlock(order.size()))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    h.indexOffset = offset;
+    h.indexSize   = index.size();
+
+    if (!write(index) || !file.seek(0)
+        || file.write(reinterpret_cast<const char*>(&h), sizeof(h))
+               != static_cast<qint64>(sizeof(h)))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool ContactBlockStore::open(const std::string& fileName)
+{
+    close();
+
+    m_file.setFileName(QString::fromStdString(fileName));
+    if (!m_file.open(QIODevice::ReadOnly))
+        return false;
+
+    m_size = static_cast<std::uint64_t>(m_file.size());
+    if (m_size < sizeof(Header))
+    {
+        close();
+        return false;
+    }
+
+    m_data = reinterpret_cast<const char*>(m_file.map(0, m_file.size()));
+    if (!m_data)
+    {
+        m_bytes = m_file.readAll();
+        m_data = m_bytes.constData();
+    }
+
+    Header h;
+    std::memcpy(&h, m_data, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0
+        || h.byteOrder != kByteOrderMark
+        || h.version != kVersion
+        || h.indexOffset > m_size
+        || h.indexSize > m_size - h.indexOffset
+        || h.blockCount > h.indexSize / kMinIndexEntry)
+    {
+        close();
+        return false;
+    }
+
+    const char* p   = m_data + h.indexOffset;
+    const char* end = p + h.indexSize;
+    m_blocks.resize(h.blockCount);
+
+    for (auto& b : m_blocks)
+    {
+        if (!get(p, end, b.offset) || !get(p, end, b.compressedSize)
+            || !get(p, end, b.rawSize) || !get(p, end, b.contactCount)
+            || !getString(p, end, b.firstKey) || !getString(p, end, b.lastKey)
+            || b.offset < sizeof(Header) || b.offset > h.indexOffset
+            || b.compressedSize > h.indexOffset - b.offset
+            || b.rawSize > kMaxBlockBytes || b.rawSize > b.compressedSize * kMaxExpansion
+            || b.contactCount > b.rawSize / kMinRecord)
+        {
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ContactBlockStore::close()
+{
+    m_file.close();
+    m_bytes.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_blocks.clear();
+}
+
+bool ContactBlockStore::readBlock(const BlockInfo& block, std::vector<Contact>& out) const
+{
+    std::string raw(block.rawSize, '\0');
+    if (!LzCodec::decompress(m_data + block.offset, block.compressedSize, &raw[0], raw.size()))
+        return false;
+
+    return ContactParser::parseAll(raw.data(), raw.data() + raw.size(), out);
+}
+
+bool ContactBlockStore::loadAll(std::vector<Contact>& out) const
+{
+    std::size_t total = 0;
+    for (const auto& b : m_blocks)
+        total += b.contactCount;
+    out.reserve(out.size() + total);
+
+    for (const auto& b : m_blocks)
+    {
+        if (!readBlock(b, out))
+            return false;
+    }
+    return true;
+}
+
+bool ContactBlockStore::findByLastName(const std::string& lastName, std::vector<Contact>& out) const
+{
+    // первый блок, который может содержать ключ
+    auto it = std::lower_bound(m_blocks.begin(), m_blocks.end(), lastName,
+                               [](const BlockInfo& b, const std::string& key)
+    {
+        return b.lastKey < key;
+    });
+
+    std::vector<Contact> block;
+    for (; it != m_blocks.end() && !(lastName < it->firstKey); ++it)
+    {
+        block.clear();
+        if (!readBlock(*it, block))
+            return false;
+
+        for (auto& c : block)
+        {
+            if (c.lastName() == lastName)
+                out.push_back(std::move(c));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QByteArray>
+#include <QFile>
+#include "Contact.h"
+
+// Архив справочника из сжатых блоков с индексом.
+//
+// Контакты упорядочиваются по фамилии и делятся на блоки примерно по blockBytes
+// исходного текста; каждый блок — записи CONTACT, сжатые LzCodec.
+// Раскладка файла:
+//   Header        — сигнатура, версия, число блоков, смещение индекса
+//   блоки         — сжатые данные подряд
+//   индекс        — на каждый блок: смещение, размеры, число контактов,
+//                   первая и последняя фамилия блока
+// Открытие читает только заголовок и индекс; поиск по фамилии
+// распаковывает лишь блоки, в диапазон которых она попадает.
+class ContactBlockStore
+{
+public:
+    static constexpr std::uint32_t kVersion = 1;
+    static constexpr std::size_t   kDefaultBlockBytes = 64 * 1024;
+    // Предел исходного текста блока: save() больших не пишет, open() не принимает
+    // (rawSize из повреждённого файла иначе даёт выделение памяти без границы)
+    static constexpr std::size_t   kMaxBlockBytes = 64 * 1024 * 1024;
+
+    struct BlockInfo
+    {
+        std::uint64_t offset = 0;
+        std::uint32_t compressedSize = 0;
+        std::uint32_t rawSize = 0;
+        std::uint32_t contactCount = 0;
+        std::string   firstKey;
+        std::string   lastKey;
+    };
+
+    static bool save(const std::vector<Contact>& contacts, const std::string& fileName,
+                     std::size_t blockBytes = kDefaultBlockBytes);
+
+    bool open(const std::string& fileName);
+    void close();
+
+    const std::vector<BlockInfo>& blocks() const { return m_blocks; }
+
+    bool loadAll(std::vector<Contact>& out) const;
+
+    // Контакты с такой фамилией; распаковываются только подходящие блоки
+    bool findByLastName(const std::string& lastName, std::vector<Contact>& out) const;
+
+private:
+    bool readBlock(const BlockInfo& block, std::vector<Contact>& out) const;
+
+    QFile                  m_file;
+    QByteArray             m_bytes;   // если отобразить файл в память не удалось
+    const char*            m_data = nullptr;
+    std::uint64_t          m_size = 0;
+    std::vector<BlockInfo> m_blocks;
+};
@@ -1,17 +1,190 @@
 #include "ContactBook.h"
+#include "ContactBlockStore.h"
+#include "ContactParser.h"
+#include "ContactSnapshot.h"
+#include "Parallel.h"
+#include "SearchKey.h"
+#include "SubstringScan.h"
+#include "Translit.h"
 #include <fstream>
 #include <algorithm>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <queue>
+#include <tuple>
+#include <unordered_set>
 #include <QFile>
 #include <QTextStream>
 #include <QString>
+#include <QByteArray>
 
+namespace {
 
+// Как часто перестройка индекса и буфера ключей проверяет отмену поиска
+constexpr std::size_t kCancelCheckRecords = 4096;
 
-bool ContactBook::loadFromFile(const std::string& fileName)
+// Только цифры; пусто — в тексте нет цифр или в нём есть что-то кроме номера
+std::string phoneDigits(std::string_view text)
 {
-    m_contacts.clear();
+    std::string digits;
+    for (char ch : text)
+    {
+        if (ch >= '0' && ch <= '9')
+            digits += ch;
+        else if (ch != '+' && ch != '-' && ch != '(' && ch != ')' && ch != ' ' && ch != '.')
+            return std::string();
+    }
+    return digits;
+}
+
+// Запрос для ключей транслитерации: сам ключ и письмо ФИО контактов, в ключах
+// которых его искать (другое, чем у запроса). Без букв или с «@» (в ФИО его
+// нет) искать незачем — key пуст
+struct TranslitQuery
+{
+    std::string      key;
+    Translit::Script records = Translit::Script::None;
+
+    explicit TranslitQuery(std::string_view text)
+    {
+        if (text.find('@') == std::string_view::npos)
+            records = Translit::opposite(Translit::script(text));
+        if (records != Translit::Script::None)
+            key = Translit::key(text);
+    }
+
+    bool matches(const TranslitKey& t, std::string_view field) const
+    {
+        return !key.empty() && t.script == records && field.find(key) != std::string_view::npos;
+    }
+};
+
+// Есть ли needle в ключе поиска. Кириллица в UTF-8 почти вся
+// начинается с байта 0xD0/0xD1, поиск по первому байту спотыкается на каждой
+// букве — для таких образцов Хорспул
+class KeyMatcher
+{
+public:
+    explicit KeyMatcher(std::string_view needle)
+        : m_needle(needle)
+        , m_ascii(static_cast<unsigned char>(needle.front()) < 0x80)
+        , m_searcher(needle.begin(), needle.end())
+    {
+    }
+
+    bool operator()(std::string_view key) const
+    {
+        if (m_ascii)
+            return key.find(m_needle) != std::string_view::npos;
+        return std::search(key.begin(), key.end(), m_searcher) != key.end();
+    }
+
+private:
+    std::string_view m_needle;
+    bool             m_ascii;
+    std::boyer_moore_horspool_searcher<std::string_view::const_iterator> m_searcher;
+};
+
+} // namespace
+
+bool ContactBook::loadFromFile(const std::string& fileName, LoadMode mode)
+{
+    std::vector<Contact> loaded;
+    const bool ok = mode == LoadMode::Mapped ? loadFromMapped(fileName, loaded)
+                                             : loadFromStream(fileName, loaded);
+    setContacts(std::move(loaded));
+    return ok;
+}
+
+void ContactBook::setContacts(std::vector<Contact>&& contacts)
+{
+    m_contacts.assign(std::move(contacts));
+    internAll();
+    invalidateColumns();
+    invalidateIndex();
+    invalidateNames();
+
+    m_searchKeys.clear();
+    m_translitKeys.clear();
+    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+        setSearchKey(m_contacts.handleAt(i));
+    ++m_revision;
+}
+
+bool ContactBook::loadFromMapped(const std::string& fileName, std::vector<Contact>& out)
+{
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    if (size == 0)
+        return true;
+
+    uchar* data = file.map(0, size);
+    if (!data)
+    {
+        // отображение недоступно (например, не обычный файл) → читаем построчно
+        file.close();
+        return loadFromStream(fileName, out);
+    }
+
+    // большие файлы разбираются кусками на всех ядрах
+    const char* begin = reinterpret_cast<const char*>(data);
+    return ContactParser::parseParallel(begin, begin + size, out, 0, m_interning);
+}
+
+bool ContactBook::streamFromFile(const std::string& fileName, std::size_t batchSize,
+                                 const BatchHandler& onBatch, bool internStrings)
+{
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    if (size == 0)
+        return true;
+
+    QByteArray bytes;
+    qint64 length = size;
+    const char* begin = reinterpret_cast<const char*>(file.map(0, size));
+    if (!begin)
+    {
+        bytes = file.readAll();
+        begin = bytes.constData();
+        length = bytes.size();
+    }
+
+    StringPool pool;
+    ContactParser parser(begin, begin + length);
+    if (internStrings)
+        parser.setPool(&pool);
+
+    std::vector<Contact> batch;
+    batch.reserve(batchSize);
+
+    Contact c;
+    while (parser.next(c))
+    {
+        batch.push_back(std::move(c));
+        if (batch.size() < batchSize)
+            continue;
+
+        if (!onBatch(std::move(batch)))
+            return false;
+        batch.clear();
+        batch.reserve(batchSize);
+    }
+
+    if (!batch.empty() && !onBatch(std::move(batch)))
+        return false;
 
+    return !parser.failed();
+}
+
+bool ContactBook::loadFromStream(const std::string& fileName, std::vector<Contact>& out)
+{
     QFile file(QString::fromStdString(fileName));
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
         return false;    // файл не найден → ok, просто пустой справочник
@@ -67,7 +240,7 @@ bool ContactBook::loadFromFile(const std::string& fileName)
             c.addPhone(PhoneNumber(number, pt));
         }
 
-        m_contacts.push_back(c);
+        out.push_back(std::move(c));
     }
 
     return true;
@@ -81,7 +254,7 @@ bool ContactBook::saveToFile(const std::string& fileName) const
 
     QTextStream out(&file);
 
-    for (const auto& c : m_contacts)
+    for (const auto& c : contacts())
     {
         out << "CONTACT\n";
         out << QString::fromStdString(c.lastName())   << "\n";
@@ -96,7 +269,7 @@ bool ContactBook::saveToFile(const std::string& fileName) const
 
         for (const auto &ph : phones)
         {
-            out << QString::fromStdString(ph.number())
+            out << QString::fromUtf8(ph.number().data(), static_cast<int>(ph.number().size()))
             << "|" << QString::fromStdString(
                 PhoneNumber::typeToString(ph.type())
                 ) << "\n";
@@ -106,95 +279,1136 @@ bool ContactBook::saveToFile(const std::string& fileName) const
     return true;
 }
 
-void ContactBook::addContact(const Contact& c)
+bool ContactBook::loadSnapshot(const std::string& fileName)
+{
+    std::vector<Contact> loaded;
+    const bool ok = ContactSnapshot::load(fileName, loaded);
+    if (!ok)
+        loaded.clear();
+    setContacts(std::move(loaded));
+    return ok;
+}
+
+bool ContactBook::saveSnapshot(const std::string& fileName) const
+{
+    return ContactSnapshot::save(contacts(), fileName);
+}
+
+bool ContactBook::loadFromBlockFile(const std::string& fileName, const std::string& lastName)
+{
+    std::vector<Contact> loaded;
+    ContactBlockStore store;
+    bool ok = store.open(fileName);
+    if (ok)
+        ok = lastName.empty() ? store.loadAll(loaded)
+                              : store.findByLastName(lastName, loaded);
+    if (!ok)
+        loaded.clear();
+    setContacts(std::move(loaded));
+    return ok;
+}
+
+bool ContactBook::saveToBlockFile(const std::string& fileName) const
+{
+    return ContactBlockStore::save(contacts(), fileName);
+}
+
+bool ContactBook::exportToFile(const std::string& fileName, ExportFormat format,
+                               const std::vector<std::size_t>* indices) const
 {
-    m_contacts.push_back(c);
+    return ContactExporter::exportFile(contacts(), fileName, format, indices);
+}
+
+void ContactBook::setStringInterning(bool enabled)
+{
+    m_interning = enabled;
+    if (enabled)
+        internAll();
+    else
+        m_pool.clear(); // уже общие значения остаются общими
+}
+
+void ContactBook::internAll()
+{
+    if (!m_interning)
+        return;
+
+    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+        m_contacts[i].intern(m_pool);
+
+    // значения прежнего содержимого справочника
+    m_pool.purge();
+}
+
+std::vector<StringFieldStats> ContactBook::stringStats() const
+{
+    std::vector<StringFieldStats> stats(4);
+    const char* names[] = { "last_name", "first_name", "middle_name", "address" };
+    std::vector<std::unordered_set<const std::string*>> seen(stats.size());
+
+    // короткие строки std::string хранит в себе, длинные — в куче
+    const std::size_t inlineCapacity = std::string().capacity();
+
+    auto count = [&](std::size_t field, const std::string& s)
+    {
+        auto& st = stats[field];
+        st.plainBytes  += sizeof(std::string) + (s.size() > inlineCapacity ? s.size() + 1 : 0);
+        st.sharedBytes += sizeof(SharedString);
+        if (s.empty())
+            return;
+
+        ++st.values;
+        // общие значения — это один и тот же объект строки
+        if (seen[field].insert(&s).second)
+        {
+            ++st.unique;
+            st.sharedBytes += SharedString::valueBytes(s);
+        }
+    };
+
+    for (const auto& c : contacts())
+    {
+        count(0, c.lastName());
+        count(1, c.firstName());
+        count(2, c.middleName());
+        count(3, c.address());
+    }
+
+    for (std::size_t i = 0; i < stats.size(); ++i)
+        stats[i].field = names[i];
+    return stats;
+}
+
+void ContactBook::clear()
+{
+    m_contacts.clear();
+    m_pool.clear();
+    invalidateColumns();
+    invalidateIndex();
+    invalidateNames();
+    m_searchKeys.clear();
+    m_translitKeys.clear();
+    ++m_revision;
+}
+
+void ContactBook::setSearchIndex(bool enabled)
+{
+    m_searchIndexing = enabled;
+    if (!enabled)
+        invalidateIndex(); // память индекса больше не нужна
+}
+
+const ContactIndex& ContactBook::index() const
+{
+    return *buildIndex(nullptr);
+}
+
+const ContactIndex* ContactBook::buildIndex(const std::atomic<bool>* cancel) const
+{
+    if (!m_indexValid)
+    {
+        // по возрастанию слотов: списки документов только дописываются в конец
+        // (после сортировки справочника порядок слотов в contacts() случайный)
+        std::vector<std::pair<std::uint32_t, std::size_t>> slots;
+        slots.reserve(m_contacts.size());
+        for (std::size_t i = 0; i < m_contacts.size(); ++i)
+            slots.emplace_back(m_contacts.handleAt(i).slot, i);
+        std::sort(slots.begin(), slots.end());
+
+        // отменили — недостроенный индекс остаётся недействительным,
+        // следующий вызов начнёт заново
+        m_index.clear();
+        for (std::size_t k = 0; k < slots.size(); ++k)
+        {
+            if (k % kCancelCheckRecords == 0 && cancel && cancel->load(std::memory_order_relaxed))
+                return nullptr;
+            const auto& [slot, i] = slots[k];
+            m_index.add(slot, m_searchKeys[slot], m_translitKeys[slot], m_contacts[i], true);
+        }
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return nullptr;
+        m_index.flushNumbers();
+        m_indexValid = true;
+    }
+    return &m_index;
+}
+
+void ContactBook::invalidateIndex()
+{
+    m_indexValid = false;
+    m_index.clear();
+}
+
+const NameTrie& ContactBook::names() const
+{
+    if (!m_namesValid)
+    {
+        m_names.clear();
+        for (std::size_t i = 0; i < m_contacts.size(); ++i)
+            m_names.add(m_contacts.handleAt(i).slot, m_contacts[i]);
+        m_namesValid = true;
+    }
+    return m_names;
+}
+
+void ContactBook::invalidateNames()
+{
+    m_namesValid = false;
+    m_names.clear();
+}
+
+void ContactBook::setSearchKey(ContactHandle h)
+{
+    if (h.slot >= m_searchKeys.size())
+    {
+        m_searchKeys.resize(h.slot + 1);
+        m_translitKeys.resize(h.slot + 1);
+    }
+
+    if (const Contact* c = m_contacts.get(h))
+    {
+        m_searchKeys[h.slot] = SearchKey::build(*c);
+        m_translitKeys[h.slot] = SearchKey::buildTranslit(*c);
+    }
+    else
+    {
+        // контакт удалён
+        std::string().swap(m_searchKeys[h.slot]);
+        m_translitKeys[h.slot] = TranslitKey();
+    }
+}
+
+std::string_view ContactBook::searchKey(std::size_t index) const
+{
+    return m_searchKeys[m_contacts.handleAt(index).slot];
+}
+
+const TranslitKey& ContactBook::translitKey(std::size_t index) const
+{
+    return m_translitKeys[m_contacts.handleAt(index).slot];
+}
+
+void ContactBook::contactAdded(ContactHandle h)
+{
+    const bool keyTextValid = m_keyTextRevision == m_revision;
+    ++m_revision;
+    setSearchKey(h);
+    if (keyTextValid)
+    {
+        // новый контакт всегда последний в contacts()
+        m_keyText += m_searchKeys[h.slot];
+        m_keyOffsets.push_back(m_keyText.size());
+        m_translitText += m_translitKeys[h.slot].text;
+        m_translitOffsets.push_back(m_translitText.size());
+        m_keyTextRevision = m_revision;
+    }
+    if (m_namesValid)
+        m_names.add(h.slot, *m_contacts.get(h));
+    if (m_indexValid)
+        m_index.add(h.slot, m_searchKeys[h.slot], m_translitKeys[h.slot], *m_contacts.get(h));
+}
+
+void ContactBook::contactChanged(ContactHandle h)
+{
+    ++m_revision;
+    setSearchKey(h);
+    invalidateNames(); // слова прежнего контакта из словаря не убрать
+    if (!m_indexValid)
+        return;
+
+    // прежние вхождения контакта остаются в индексе; когда устаревших
+    // больше, чем контактов, дешевле построить индекс заново при следующем поиске
+    m_index.markStale();
+    if (m_index.staleCount() > m_contacts.size())
+    {
+        invalidateIndex();
+        return;
+    }
+    if (const Contact* c = m_contacts.get(h))
+        m_index.add(h.slot, m_searchKeys[h.slot], m_translitKeys[h.slot], *c);
+}
+
+bool ContactBook::updateKeyText(const std::atomic<bool>* cancel) const
+{
+    if (m_keyTextRevision == m_revision)
+        return true;
+
+    std::size_t total = 0;
+    std::size_t translitTotal = 0;
+    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+    {
+        total += searchKey(i).size();
+        translitTotal += translitKey(i).text.size();
+    }
+
+    m_keyText.clear();
+    m_keyText.reserve(total);
+    m_keyOffsets.assign(1, 0);
+    m_keyOffsets.reserve(m_contacts.size() + 1);
+    m_translitText.clear();
+    m_translitText.reserve(translitTotal);
+    m_translitOffsets.assign(1, 0);
+    m_translitOffsets.reserve(m_contacts.size() + 1);
+    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+    {
+        // отменили — буфер остаётся устаревшим (m_keyTextRevision прежний)
+        if (i % kCancelCheckRecords == 0 && cancel && cancel->load(std::memory_order_relaxed))
+            return false;
+        m_keyText += searchKey(i);
+        m_keyOffsets.push_back(m_keyText.size());
+        m_translitText += translitKey(i).text;
+        m_translitOffsets.push_back(m_translitText.size());
+    }
+    m_keyTextRevision = m_revision;
+    return true;
+}
+
+const ContactStore& ContactBook::columns() const
+{
+    if (!m_columnsValid)
+    {
+        m_columns.assign(contacts());
+        m_columnsValid = true;
+    }
+    return m_columns;
+}
+
+ContactHandle ContactBook::addContact(const Contact& c)
+{
+    return added(m_contacts.emplace(c));
+}
+
+ContactHandle ContactBook::addContact(Contact&& c)
+{
+    return added(m_contacts.emplace(std::move(c)));
+}
+
+ContactHandle ContactBook::added(ContactHandle h)
+{
+    Contact& c = *m_contacts.get(h);
+    if (m_interning)
+        c.intern(m_pool);
+
+    // дописать в конец столбцов и индекса дешевле, чем перестраивать их
+    if (m_columnsValid)
+        m_columns.append(c);
+    contactAdded(h);
+    return h;
+}
+
+bool ContactBook::removeContact(ContactHandle h)
+{
+    // следующие контакты сдвигаются, порядок (и сортировка) сохраняется
+    if (!m_contacts.erase(h))
+        return false;
+    invalidateColumns();
+    contactChanged(h);
+    return true;
 }
 
 bool ContactBook::removeContact(std::size_t index)
 {
-    if (index >= m_contacts.size())
+    return index < m_contacts.size() && removeContact(m_contacts.handleAt(index));
+}
+
+bool ContactBook::updateContact(ContactHandle h, const Contact& c)
+{
+    return updateContact(h, Contact(c));
+}
+
+bool ContactBook::updateContact(ContactHandle h, Contact&& c)
+{
+    Contact* target = m_contacts.get(h);
+    if (!target)
         return false;
-    m_contacts.erase(m_contacts.begin() + static_cast<long>(index));
+    *target = std::move(c);
+    if (m_interning)
+        target->intern(m_pool);
+    invalidateColumns();
+    contactChanged(h);
     return true;
 }
 
+std::size_t ContactBook::applyChanges(std::vector<ContactChange>&& changes,
+                                      std::vector<ContactHandle>* addedHandles)
+{
+    std::size_t adds = 0;
+    for (const auto& ch : changes)
+        adds += ch.kind == ContactChange::Kind::Add;
+    reserve(m_contacts.size() + adds);
+
+    std::size_t applied = 0;
+    bool changed = false;   // меняли или удаляли — столбцы перестраиваются
+    for (auto& ch : changes)
+    {
+        switch (ch.kind)
+        {
+        case ContactChange::Kind::Add:
+        {
+            const ContactHandle h = m_contacts.emplace(std::move(ch.contact));
+            if (m_interning)
+                m_contacts.get(h)->intern(m_pool);
+            contactAdded(h);
+            if (addedHandles)
+                addedHandles->push_back(h);
+            ++applied;
+            break;
+        }
+        case ContactChange::Kind::Update:
+            if (Contact* target = m_contacts.get(ch.handle))
+            {
+                *target = std::move(ch.contact);
+                if (m_interning)
+                    target->intern(m_pool);
+                contactChanged(ch.handle);
+                changed = true;
+                ++applied;
+            }
+            break;
+        case ContactChange::Kind::Remove:
+            // дыры закрываются одним сдвигом после всей пачки
+            if (m_contacts.eraseDeferred(ch.handle))
+            {
+                contactChanged(ch.handle);
+                changed = true;
+                ++applied;
+            }
+            break;
+        }
+    }
+
+    m_contacts.compact();
+    if (changed)
+        m_pool.purge(); // значения, которые были только у заменённых и удалённых
+    invalidateColumns();
+    return applied;
+}
+
 bool ContactBook::updateContact(std::size_t index, const Contact& c)
 {
-    if (index >= m_contacts.size())
+    return index < m_contacts.size() && updateContact(m_contacts.handleAt(index), c);
+}
+
+bool ContactBook::updateContact(std::size_t index, Contact&& c)
+{
+    return index < m_contacts.size() && updateContact(m_contacts.handleAt(index), std::move(c));
+}
+
+std::vector<std::size_t> ContactBook::find(const std::string& text) const
+{
+    std::vector<std::size_t> result;
+    findInto(text, result, nullptr);
+    return result;
+}
+
+bool ContactBook::find(const std::string& text, std::vector<std::size_t>& out, const std::atomic<bool>& cancel) const
+{
+    return findInto(text, out, &cancel);
+}
+
+bool ContactBook::findInto(const std::string& text, std::vector<std::size_t>& out,
+                           const std::atomic<bool>* cancel) const
+{
+    out.clear();
+    const std::string needle = SearchKey::fold(text);
+    if (needle.empty())
+        return true;
+
+    // индекс и буфер ключей после изменений строятся заново — тоже с отменой
+    const ContactIndex* idx = nullptr;
+    if (m_searchIndexing && !(idx = buildIndex(cancel)))
         return false;
-    m_contacts[index] = c;
+
+    std::vector<std::size_t> result;
+    std::vector<std::uint32_t> docs;
+    if (idx && idx->candidates(needle, docs))
+    {
+        // проверяются только кандидаты из индекса
+        const KeyMatcher matcher(needle);
+        for (std::uint32_t doc : docs)
+        {
+            const std::size_t i = m_contacts.indexOfSlot(doc);
+            if (i != SlotMap<Contact>::npos && matcher(m_searchKeys[doc]))
+                result.push_back(i);
+        }
+        std::sort(result.begin(), result.end()); // кандидаты шли по слотам
+    }
+    else
+    {
+        if (!updateKeyText(cancel) || !scanKeys(m_keyText, m_keyOffsets, needle, result, cancel))
+            return false;
+    }
+
+    if (!addTranslitMatches(result, text, cancel))
+        return false;
+    out = withPhoneMatches(std::move(result), text);
+    if (cancel && cancel->load(std::memory_order_relaxed))
+    {
+        out.clear();
+        return false;
+    }
     return true;
 }
 
-std::vector<std::size_t> ContactBook::find(const std::string& text) const
+bool ContactBook::addTranslitMatches(std::vector<std::size_t>& result, const std::string& text,
+                                     const std::atomic<bool>* cancel) const
 {
+    // «Ivanov» находит «Иванов» и наоборот: запрос переводится один раз,
+    // ключи транслитерации контактов построены заранее
+    const TranslitQuery query(text);
+    if (query.key.empty())
+        return true;
+    const std::string& needle = query.key;
+
+    // found — позиции по возрастанию, которых ещё нет в result
+    std::vector<std::size_t> found;
+    std::vector<std::uint32_t> docs;
+    if (m_searchIndexing && index().candidates(needle, docs, query.records))
+    {
+        found.reserve(docs.size());
+        for (std::uint32_t doc : docs)
+        {
+            const std::size_t i = m_contacts.indexOfSlot(doc);
+            if (i != SlotMap<Contact>::npos)
+                found.push_back(i);
+        }
+        std::sort(found.begin(), found.end());
+
+        // найденные по ключу поиска (обычно почти все) не проверяются
+        const KeyMatcher matcher(needle);
+        std::size_t kept = 0;
+        auto r = result.cbegin();
+        for (std::size_t i : found)
+        {
+            r = std::lower_bound(r, result.cend(), i);
+            const TranslitKey& t = translitKey(i);
+            if ((r == result.cend() || *r != i) && t.script == query.records && matcher(t.text))
+                found[kept++] = i;
+        }
+        found.resize(kept);
+    }
+    else
+    {
+        std::vector<std::size_t> scanned;
+        if (!updateKeyText(cancel) || !scanKeys(m_translitText, m_translitOffsets, needle, scanned, cancel))
+            return false;
+        // в буфере ключи контактов обоих писем — нужны только другого
+        scanned.erase(std::remove_if(scanned.begin(), scanned.end(), [&](std::size_t i) {
+            return translitKey(i).script != query.records;
+        }), scanned.end());
+        std::set_difference(scanned.begin(), scanned.end(), result.begin(), result.end(),
+                            std::back_inserter(found));
+    }
+
+    const std::size_t matched = result.size();
+    result.insert(result.end(), found.begin(), found.end());
+    std::inplace_merge(result.begin(), result.begin() + matched, result.end());
+    return true;
+}
+
+bool ContactBook::scanKeys(const std::string& text, const std::vector<std::size_t>& offsets,
+                           std::string_view needle, std::vector<std::size_t>& out,
+                           const std::atomic<bool>* cancel) const
+{
+    // без индекса или образец короче триграммы — ключи всех контактов
+    // по общему буферу (text, offsets — m_keyText или m_translitText),
+    // частями примерно по kPartBytes
+    constexpr std::size_t kPartBytes = 256 * 1024;
+    const std::size_t records = offsets.size() - 1;
+    const std::size_t bytes = text.size();
+
+    unsigned threads = m_searchThreads;
+    if (threads == 0)
+        threads = bytes >= kParallelScanBytes ? Parallel::workerCount() : 1;
+    std::size_t parts = bytes / kPartBytes + 1;
+    if (threads > 1)
+        parts = std::max<std::size_t>(parts, threads * 4); // чтобы потоки закончили вместе
+    parts = std::max<std::size_t>(1, std::min(parts, records));
+
+    // границы частей — по записям, частям поровну байт
+    std::vector<std::size_t> bounds{0};
+    for (std::size_t k = 1; k < parts; ++k)
+    {
+        const std::size_t record = static_cast<std::size_t>(
+            std::upper_bound(offsets.begin(), offsets.end(), bytes / parts * k) - offsets.begin()) - 1;
+        if (record > bounds.back() && record < records)
+            bounds.push_back(record);
+    }
+    bounds.push_back(records);
+
+    auto cancelled = [cancel]() { return cancel && cancel->load(std::memory_order_relaxed); };
+    std::vector<std::vector<std::size_t>> found(bounds.size() - 1);
+    Parallel::forEach(found.size(), [&](std::size_t k)
+    {
+        if (!cancelled())
+            SubstringScan::scan(text, offsets, bounds[k], bounds[k + 1], needle, found[k]);
+    }, threads);
+
+    if (cancelled())
+        return false;
+
+    // части шли по порядку записей — склейка сохраняет порядок contacts()
+    std::size_t total = 0;
+    for (const auto& part : found)
+        total += part.size();
+    out.reserve(total);
+    for (const auto& part : found)
+        out.insert(out.end(), part.begin(), part.end());
+    return true;
+}
+
+std::vector<std::size_t> ContactBook::refine(const std::vector<std::size_t>& previous,
+                                             const std::string& previousText,
+                                             const std::string& text) const
+{
+    const std::string needle = SearchKey::fold(text);
+    if (needle.empty())
+        return std::vector<std::size_t>();
+
+    // индекс даёт меньше кандидатов, чем было найдено, — обычный поиск дешевле
+    if (m_searchIndexing && index().candidateBound(needle) < previous.size())
+        return find(text);
+
+    // ключ транслитерации продолжает прежний («ив» → «iv» после «i») — его
+    // совпадения тоже среди previous; не продолжает («sc» → «sch» = «щ»)
+    // или письмо другое — ищутся заново
+    const TranslitQuery translit(text);
+    const TranslitQuery before(previousText);
+    const bool narrowTranslit = translit.key.empty()
+        || (!before.key.empty() && before.records == translit.records
+            && translit.key.compare(0, before.key.size(), before.key) == 0);
+
+    // ключ, где есть needle, содержит и его начало — достаточно проверить previous
+    const KeyMatcher matcher(needle);
     std::vector<std::size_t> result;
-    if (text.empty())
-        return result;
+    for (std::size_t i : previous)
+    {
+        if (i < m_contacts.size()
+            && (matcher(searchKey(i)) || (narrowTranslit && translit.matches(translitKey(i), translitKey(i).text))))
+        {
+            result.push_back(i);
+        }
+    }
 
-    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+    if (!narrowTranslit)
+        addTranslitMatches(result, text, nullptr);
+
+    // совпадения по номеру так не сужаются («78» → «781»), они ищутся заново по индексу
+    return withPhoneMatches(std::move(result), text);
+}
+
+std::vector<std::size_t> ContactBook::withPhoneMatches(std::vector<std::size_t> result,
+                                                       const std::string& text) const
+{
+    const std::size_t matched = result.size();
+
+    // кусок номера в другой записи: «1234567» находит «+7(812)123-45-67»
+    const std::string digits = phoneDigits(text);
+    if (digits.size() >= ContactIndex::kGram)
     {
-        const auto& c = m_contacts[i];
-        auto inStr = [&](const std::string& s)
+        const std::vector<std::size_t> byDigits = digitMatches(digits, DigitMatch::Infix);
+        result.insert(result.end(), byDigits.begin(), byDigits.end());
+    }
+
+    // тот же номер в другой записи
+    if (const std::uint64_t canonical = PhoneNumber::canonicalize(text))
+    {
+        if (m_searchIndexing)
+        {
+            if (const auto* phoneDocs = index().phoneDocs(canonical))
+            {
+                for (std::uint32_t doc : *phoneDocs)
+                {
+                    const std::size_t i = m_contacts.indexOfSlot(doc);
+                    if (i != SlotMap<Contact>::npos && matchesPhone(i, canonical))
+                        result.push_back(i);
+                }
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < m_contacts.size(); ++i)
+            {
+                if (matchesPhone(i, canonical))
+                    result.push_back(i);
+            }
+        }
+    }
+
+    if (result.size() != matched)
+    {
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+    return result;
+}
+
+QueryPlan ContactBook::planQuery(const ContactQuery& query) const
+{
+    QueryPlan plan;
+    if (!m_searchIndexing)
+        return plan;
+
+    for (std::size_t k = 0; k < query.terms().size(); ++k)
+    {
+        const ContactQuery::Term& term = query.terms()[k];
+        QueryPlan::Step step;
+        step.term = k;
+        switch (term.field)
+        {
+        case ContactQuery::Field::Any:
+        {
+            // find() сам пройдёт по индексу; короче триграммы — просмотр всех, шага нет
+            const std::string needle = SearchKey::fold(term.value);
+            const TranslitQuery translit(term.value);
+            if (needle.size() < ContactIndex::kGram
+                || (!translit.key.empty() && translit.key.size() < ContactIndex::kGram))
+                continue;
+            const std::string digits = phoneDigits(term.value);
+            step.access = QueryPlan::Access::Find;
+            step.estimate = index().candidateBound(needle)
+                          + (translit.key.empty() ? 0 : index().candidateBound(translit.key, translit.records))
+                          + (digits.size() >= ContactIndex::kGram ? index().digitBound(digits) : 0);
+            break;
+        }
+        case ContactQuery::Field::LastName:
+        case ContactQuery::Field::FirstName:
+        case ContactQuery::Field::MiddleName:
+        {
+            // ФИО ищется и в ключах транслитерации — кандидатов из обоих списков
+            const std::string needle = SearchKey::fold(term.value);
+            const TranslitQuery translit(term.value);
+            if (needle.size() < ContactIndex::kGram
+                || (!translit.key.empty() && translit.key.size() < ContactIndex::kGram))
+                continue;
+            step.access = QueryPlan::Access::Trigram;
+            step.estimate = index().candidateBound(needle)
+                          + (translit.key.empty() ? 0 : index().candidateBound(translit.key, translit.records));
+            break;
+        }
+        case ContactQuery::Field::Address:
+        case ContactQuery::Field::Email:
+        {
+            const std::string needle = SearchKey::fold(term.value);
+            if (needle.size() < ContactIndex::kGram)
+                continue;
+            step.access = QueryPlan::Access::Trigram;
+            step.estimate = index().candidateBound(needle);
+            break;
+        }
+        case ContactQuery::Field::Phone:
+            step.access = QueryPlan::Access::PhoneDigits;
+            step.estimate = index().digitBound(term.value);
+            break;
+        case ContactQuery::Field::Born:
+        {
+            const auto range = birthRange(term.from, term.to);
+            step.access = QueryPlan::Access::BirthDate;
+            step.estimate = range.second - range.first;
+            break;
+        }
+        case ContactQuery::Field::Type:
+            continue; // типов всего четыре — индекс не поможет
+        }
+        plan.steps.push_back(step);
+    }
+
+    std::stable_sort(plan.steps.begin(), plan.steps.end(),
+                     [](const QueryPlan::Step& a, const QueryPlan::Step& b) { return a.estimate < b.estimate; });
+    return plan;
+}
+
+std::vector<std::size_t> ContactBook::findQuery(const ContactQuery& query) const
+{
+    const std::vector<ContactQuery::Term>& terms = query.terms();
+    if (terms.empty())
+        return std::vector<std::size_t>();
+
+    // кандидаты: первый шаг плана, дальше пересечение, пока следующий список
+    // не длиннее кандидатов в kIntersectFactor раз — иначе проще проверить условие
+    constexpr std::size_t kIntersectFactor = 8;
+    const QueryPlan plan = planQuery(query);
+    std::vector<std::size_t> candidates;
+    std::vector<char> exact(terms.size(), 0);   // условие уже выполнено у всех кандидатов
+    for (std::size_t s = 0; s < plan.steps.size(); ++s)
+    {
+        const QueryPlan::Step& step = plan.steps[s];
+        if (s != 0 && step.estimate > candidates.size() * kIntersectFactor)
+            break;
+
+        std::vector<std::size_t> matches = stepMatches(terms[step.term], step.access);
+        if (s == 0)
+        {
+            candidates = std::move(matches);
+        }
+        else
+        {
+            std::vector<std::size_t> both;
+            std::set_intersection(candidates.begin(), candidates.end(), matches.begin(), matches.end(),
+                                  std::back_inserter(both));
+            candidates.swap(both);
+        }
+        exact[step.term] = step.access == QueryPlan::Access::Find || step.access == QueryPlan::Access::BirthDate;
+        if (candidates.empty())
+            return candidates;
+    }
+
+    // сложенные образцы — один раз на запрос
+    std::vector<std::string> needles(terms.size());
+    std::vector<TranslitQuery> translits;
+    translits.reserve(terms.size());
+    std::vector<std::string> digits(terms.size());
+    std::vector<std::uint64_t> canonical(terms.size(), 0);
+    for (std::size_t k = 0; k < terms.size(); ++k)
+    {
+        needles[k] = SearchKey::fold(terms[k].value);
+        translits.emplace_back(terms[k].field <= ContactQuery::Field::MiddleName ? terms[k].value : std::string());
+        if (terms[k].field == ContactQuery::Field::Any)
         {
-            return s.find(text) != std::string::npos;
-        };
+            digits[k] = phoneDigits(terms[k].value);
+            canonical[k] = PhoneNumber::canonicalize(terms[k].value);
+        }
+    }
+    const PhoneType* phoneType = query.phoneType();
 
-        bool match = inStr(c.lastName()) ||
-                     inStr(c.firstName()) ||
-                     inStr(c.middleName()) ||
-                     inStr(c.email()) ||
-                     inStr(c.address());
+    std::string folded;
+    auto fieldHas = [&folded](const std::string& field, const std::string& needle) {
+        folded.clear();
+        SearchKey::appendFolded(folded, field);
+        return folded.find(needle) != std::string::npos;
+    };
 
-        if (!match)
+    auto matches = [&](std::size_t i) {
+        const Contact& c = m_contacts[i];
+        const TranslitKey& t = translitKey(i);
+        for (std::size_t k = 0; k < terms.size(); ++k)
         {
-            for (const auto& ph : c.phones())
+            if (exact[k])
+                continue;
+
+            const ContactQuery::Term& term = terms[k];
+            bool ok = false;
+            switch (term.field)
             {
-                if (ph.number().find(text) != std::string::npos)
+            case ContactQuery::Field::Any:
+                // как find(): ключ, транслитерация, кусок номера, тот же номер в другой записи
+                ok = searchKey(i).find(needles[k]) != std::string_view::npos
+                  || translits[k].matches(t, t.text)
+                  || (digits[k].size() >= ContactIndex::kGram && matchesDigits(i, digits[k], DigitMatch::Infix))
+                  || (canonical[k] != 0 && matchesPhone(i, canonical[k]));
+                break;
+            case ContactQuery::Field::LastName:
+                ok = fieldHas(c.lastName(), needles[k]) || translits[k].matches(t, t.lastName());
+                break;
+            case ContactQuery::Field::FirstName:
+                ok = fieldHas(c.firstName(), needles[k]) || translits[k].matches(t, t.firstName());
+                break;
+            case ContactQuery::Field::MiddleName:
+                ok = fieldHas(c.middleName(), needles[k]) || translits[k].matches(t, t.middleName());
+                break;
+            case ContactQuery::Field::Address:    ok = fieldHas(c.address(), needles[k]); break;
+            case ContactQuery::Field::Email:      ok = fieldHas(c.email(), needles[k]); break;
+            case ContactQuery::Field::Phone:
+                for (const auto& ph : c.phones())
                 {
-                    match = true;
-                    break;
+                    char buf[PhoneNumber::kMaxDigits];
+                    const std::string_view number(buf, PhoneNumber::digits(ph.canonical(), buf));
+                    if (ph.canonical() != 0 && (!phoneType || ph.type() == *phoneType)
+                        && number.find(term.value) != std::string_view::npos)
+                    {
+                        ok = true;
+                        break;
+                    }
                 }
+                break;
+            case ContactQuery::Field::Born:
+                ok = c.birthDate() >= term.from && c.birthDate() <= term.to;
+                break;
+            case ContactQuery::Field::Type:
+                for (const auto& ph : c.phones())
+                    ok = ok || ph.type() == term.type;
+                break;
             }
+            if (!ok)
+                return false;
         }
+        return true;
+    };
 
-        if (match)
+    std::vector<std::size_t> result;
+    if (plan.steps.empty())
+    {
+        for (std::size_t i = 0; i < m_contacts.size(); ++i)
+        {
+            if (matches(i))
+                result.push_back(i);
+        }
+        return result;
+    }
+
+    for (std::size_t i : candidates)
+    {
+        if (matches(i))
             result.push_back(i);
     }
+    return result;
+}
 
+std::vector<std::size_t> ContactBook::stepMatches(const ContactQuery::Term& term, QueryPlan::Access access) const
+{
+    std::vector<std::size_t> result;
+    std::vector<std::uint32_t> docs;
+    switch (access)
+    {
+    case QueryPlan::Access::Find:
+        return find(term.value);
+
+    case QueryPlan::Access::BirthDate:
+    {
+        const auto range = birthRange(term.from, term.to);
+        result.reserve(range.second - range.first);
+        for (std::size_t k = range.first; k < range.second; ++k)
+            result.push_back(m_birthOrder[k].second);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    case QueryPlan::Access::Trigram:
+        index().candidates(SearchKey::fold(term.value), docs);
+        if (term.field <= ContactQuery::Field::MiddleName)
+        {
+            std::vector<std::uint32_t> translitDocs;
+            const TranslitQuery translit(term.value);
+            if (!translit.key.empty() && index().candidates(translit.key, translitDocs, translit.records))
+                docs.insert(docs.end(), translitDocs.begin(), translitDocs.end());
+        }
+        break;
+
+    case QueryPlan::Access::PhoneDigits:
+        index().findDigits(term.value, DigitMatch::Infix, docs);
+        break;
+    }
+
+    // документы — слоты; кандидаты ещё проверяются по условию
+    result.reserve(docs.size());
+    for (std::uint32_t doc : docs)
+    {
+        const std::size_t i = m_contacts.indexOfSlot(doc);
+        if (i != SlotMap<Contact>::npos)
+            result.push_back(i);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end()); // ФИО: из обоих списков
     return result;
 }
 
-void ContactBook::sortBy(SortField field, bool ascending)
+std::pair<std::size_t, std::size_t> ContactBook::birthRange(Date from, Date to) const
 {
-    auto cmp = [&](const Contact& a, const Contact& b)
+    if (m_birthOrderRevision != m_revision)
     {
-        bool less = false;
-        bool greater = false;
+        m_birthOrder.clear();
+        m_birthOrder.reserve(m_contacts.size());
+        for (std::size_t i = 0; i < m_contacts.size(); ++i)
+            m_birthOrder.emplace_back(m_contacts[i].birthDate().packed(), static_cast<std::uint32_t>(i));
+        std::sort(m_birthOrder.begin(), m_birthOrder.end());
+        m_birthOrderRevision = m_revision;
+    }
+
+    auto first = std::lower_bound(m_birthOrder.begin(), m_birthOrder.end(), std::make_pair(from.packed(), std::uint32_t(0)));
+    auto last = std::upper_bound(first, m_birthOrder.end(), std::make_pair(to.packed(), ~std::uint32_t(0)));
+    return { static_cast<std::size_t>(first - m_birthOrder.begin()), static_cast<std::size_t>(last - m_birthOrder.begin()) };
+}
+
+unsigned ContactBook::maxTypos(std::size_t letters)
+{
+    return letters <= 2 ? 0 : letters <= 5 ? 1 : 2;
+}
+
+std::vector<FuzzyMatch> ContactBook::findFuzzy(const std::string& text, std::size_t k) const
+{
+    const std::vector<std::u32string> queryWords = NameTrie::words(text);
+    if (queryWords.empty() || k == 0)
+        return std::vector<FuzzyMatch>();
+
+    const NameTrie& dict = names();
+    const std::size_t slots = m_searchKeys.size();
 
-        switch (field)
+    // по слотам: сколько слов запроса уже совпало, сумма опечаток и полей
+    // (опечатки << 8 | поля); best — лучшее совпадение текущего слова
+    constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+    std::vector<std::uint16_t> matchedWords(slots, 0);
+    std::vector<std::uint32_t> score(slots, 0);
+    std::vector<std::uint32_t> best(slots, kNone);
+
+    std::vector<NameTrie::WordMatch> words;
+    std::vector<std::uint32_t> touched;
+    for (std::size_t w = 0; w < queryWords.size(); ++w)
+    {
+        dict.search(queryWords[w], maxTypos(queryWords[w].size()), words);
+
+        touched.clear();
+        for (const auto& m : words)
         {
-        case SortField::LastName:
-            less = a.lastName() < b.lastName();
-            greater = b.lastName() < a.lastName();
-            break;
+            for (std::uint32_t posting : dict.postings(m.word))
+            {
+                const std::uint32_t slot = posting >> 2;
+                if (matchedWords[slot] != w)
+                    continue; // не совпал с одним из прежних слов
+                if (best[slot] == kNone)
+                    touched.push_back(slot);
+                best[slot] = std::min(best[slot], m.distance << 8 | (posting & 3));
+            }
+        }
 
-        case SortField::BirthDate:
+        for (std::uint32_t slot : touched)
         {
-            const auto& da = a.birthDate();
-            const auto& db = b.birthDate();
+            ++matchedWords[slot];
+            score[slot] += best[slot];
+            best[slot] = kNone;
+        }
+    }
 
-            if (da.year != db.year) { less = da.year < db.year; greater = db.year < da.year; }
-            else if (da.month != db.month) { less = da.month < db.month; greater = db.month < da.month; }
-            else { less = da.day < db.day; greater = db.day < da.day; }
-            break;
+    // k лучших — в куче из k элементов, наверху худший из них
+    using Ranked = std::tuple<std::uint32_t, std::size_t>;   // счёт, позиция
+    std::priority_queue<Ranked> top;
+    for (std::uint32_t slot : touched)
+    {
+        const std::size_t i = m_contacts.indexOfSlot(slot);
+        if (i == SlotMap<Contact>::npos)
+            continue;
+        const Ranked ranked(score[slot], i);
+        if (top.size() < k)
+            top.push(ranked);
+        else if (ranked < top.top())
+        {
+            top.pop();
+            top.push(ranked);
         }
+    }
+
+    std::vector<FuzzyMatch> result(top.size());
+    for (std::size_t n = result.size(); n-- > 0; top.pop())
+        result[n] = FuzzyMatch{ std::get<1>(top.top()), std::get<0>(top.top()) >> 8 };
+    return result;
+}
+
+std::vector<std::size_t> ContactBook::findByPhone(const std::string& number) const
+{
+    std::vector<std::size_t> result;
+    const std::uint64_t canonical = PhoneNumber::canonicalize(number);
+    if (canonical == 0)
+        return result;
+
+    if (m_searchIndexing)
+    {
+        if (const auto* docs = index().phoneDocs(canonical))
+        {
+            for (std::uint32_t doc : *docs)
+            {
+                const std::size_t i = m_contacts.indexOfSlot(doc);
+                if (i != SlotMap<Contact>::npos && matchesPhone(i, canonical))
+                    result.push_back(i);
+            }
         }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
 
-        return ascending ? less : greater;
-    };
+    const ContactStore& store = columns();
+    std::vector<char> hits(store.size(), 0);
+    store.markPhone(canonical, hits);
+
+    for (std::size_t i = 0; i < hits.size(); ++i)
+    {
+        if (hits[i])
+            result.push_back(i);
+    }
+
+    return result;
+}
+
+std::vector<ContactHandle> ContactBook::findByDigits(const std::string& fragment, DigitMatch match) const
+{
+    std::string digits;
+    for (char ch : fragment)
+    {
+        if (ch >= '0' && ch <= '9')
+            digits += ch;
+    }
+
+    std::vector<ContactHandle> result;
+    if (digits.empty() || digits.size() > PhoneNumber::kMaxDigits)
+        return result;
+
+    for (std::size_t i : digitMatches(digits, match))
+        result.push_back(m_contacts.handleAt(i));
+    return result;
+}
+
+std::vector<std::size_t> ContactBook::digitMatches(std::string_view digits, DigitMatch match) const
+{
+    std::vector<std::size_t> result;
+    if (m_searchIndexing)
+    {
+        std::vector<std::uint32_t> docs;
+        index().findDigits(digits, match, docs);
+        for (std::uint32_t doc : docs)
+        {
+            const std::size_t i = m_contacts.indexOfSlot(doc);
+            if (i != SlotMap<Contact>::npos && matchesDigits(i, digits, match))
+                result.push_back(i);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    for (std::size_t i = 0; i < m_contacts.size(); ++i)
+    {
+        if (matchesDigits(i, digits, match))
+            result.push_back(i);
+    }
+    return result;
+}
+
+bool ContactBook::matchesDigits(std::size_t index, std::string_view digits, DigitMatch match) const
+{
+    for (const auto& ph : m_contacts[index].phones())
+    {
+        if (ph.canonical() == 0)
+            continue;
+
+        char buf[PhoneNumber::kMaxDigits];
+        const std::string_view number(buf, PhoneNumber::digits(ph.canonical(), buf));
+        if (number.size() < digits.size())
+            continue;
+
+        const bool hit =
+            match == DigitMatch::Prefix ? number.compare(0, digits.size(), digits) == 0
+          : match == DigitMatch::Suffix ? number.compare(number.size() - digits.size(), digits.size(), digits) == 0
+                                        : number.find(digits) != std::string_view::npos;
+        if (hit)
+            return true;
+    }
+    return false;
+}
 
-    std::sort(m_contacts.begin(), m_contacts.end(), cmp);
+bool ContactBook::matchesPhone(std::size_t index, std::uint64_t canonical) const
+{
+    for (const auto& ph : m_contacts[index].phones())
+    {
+        if (ph.canonical() == canonical)
+            return true;
+    }
+    return false;
 }
 
+void ContactBook::sortBy(SortField field, bool ascending)
+{
+    // ключи сравниваются по столбцу, объекты Contact переставляются один раз,
+    // handle остаются прежними
+    // (сортировка устойчивая: повтор из журнала даёт тот же порядок)
+    const std::vector<std::size_t> order = columns().sortedOrder(field, ascending);
+    m_contacts.permute(order);
+    m_columns.permute(order);
+    ++m_revision;
+}
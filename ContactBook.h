@@ -1,28 +1,324 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include "Contact.h"
+#include "ContactExporter.h"
+#include "ContactIndex.h"
+#include "ContactQuery.h"
+#include "ContactStore.h"
+#include "NameTrie.h"
+#include "SearchKey.h"
+#include "SlotMap.h"
+#include "StringPool.h"
 
-enum class SortField {
-    LastName,
-    BirthDate
+// Способ чтения contacts.txt
+enum class LoadMode {
+    Stream,   // построчно через QTextStream
+    Mapped    // файл отображается в память и разбирается на месте
+};
+
+// Память под одно строковое поле всех контактов (см. ContactBook::stringStats)
+struct StringFieldStats
+{
+    std::string field;
+    std::size_t values = 0;       // непустых значений
+    std::size_t unique = 0;       // различных строк в памяти
+    std::size_t plainBytes = 0;   // заняли бы отдельные std::string
+    std::size_t sharedBytes = 0;  // занимают сейчас
+
+    std::size_t savedBytes() const { return plainBytes > sharedBytes ? plainBytes - sharedBytes : 0; }
+};
+
+// Постоянная ссылка на контакт: не меняется при удалении других контактов
+// и при сортировке; после удаления самого контакта перестаёт находиться.
+using ContactHandle = SlotHandle;
+
+// Одно изменение для ContactBook::applyChanges
+struct ContactChange
+{
+    enum class Kind { Add, Update, Remove };
+
+    Kind          kind = Kind::Add;
+    ContactHandle handle;    // Update, Remove
+    Contact       contact;   // Add, Update — переносится в справочник
+
+    static ContactChange add(Contact c)                     { return { Kind::Add, {}, std::move(c) }; }
+    static ContactChange update(ContactHandle h, Contact c) { return { Kind::Update, h, std::move(c) }; }
+    static ContactChange remove(ContactHandle h)            { return { Kind::Remove, h, Contact() }; }
+};
+
+// Контакт, найденный ContactBook::findFuzzy
+struct FuzzyMatch
+{
+    std::size_t index = 0;      // позиция в contacts()
+    unsigned    distance = 0;   // опечаток во всех словах запроса
+};
+
+// Как ContactBook::findQuery выполнит запрос
+struct QueryPlan
+{
+    enum class Access {
+        Find,          // слово без поля — ContactBook::find
+        Trigram,       // триграммы ключа поиска (ContactIndex::candidates)
+        PhoneDigits,   // суффиксный массив цифр номеров (ContactIndex::findDigits)
+        BirthDate      // контакты по дате рождения, отрезок — двоичным поиском
+    };
+
+    struct Step
+    {
+        Access      access = Access::Find;
+        std::size_t term = 0;       // номер условия в ContactQuery::terms()
+        std::size_t estimate = 0;   // кандидатов самое большее
+    };
+
+    // По возрастанию оценки; пусто — индексы не помогают, проверяются все контакты
+    std::vector<Step> steps;
 };
 
 class ContactBook
 {
 public:
-    bool loadFromFile(const std::string& fileName);
+    bool loadFromFile(const std::string& fileName, LoadMode mode = LoadMode::Mapped);
     bool saveToFile(const std::string& fileName) const;
 
-    void addContact(const Contact& c);
+    // Потоковое чтение contacts.txt: контакты отдаются пачками по batchSize
+    // по мере разбора (можно вызывать из фонового потока — справочник не меняется).
+    // onBatch вернул false → чтение прерывается.
+    // internStrings — повторяющиеся строки разбираются в общие значения (меньше выделений памяти).
+    using BatchHandler = std::function<bool(std::vector<Contact>&& batch)>;
+    static bool streamFromFile(const std::string& fileName, std::size_t batchSize,
+                               const BatchHandler& onBatch, bool internStrings = false);
+
+    // Двоичный снимок (см. ContactSnapshot) — быстрый старт без разбора текста
+    bool loadSnapshot(const std::string& fileName);
+    bool saveSnapshot(const std::string& fileName) const;
+
+    // Архив из сжатых блоков (см. ContactBlockStore).
+    // lastName не пуст → загружаются только контакты с этой фамилией,
+    // распаковываются лишь блоки, где она может быть.
+    bool loadFromBlockFile(const std::string& fileName,
+                           const std::string& lastName = std::string());
+    bool saveToBlockFile(const std::string& fileName) const;
+
+    // Выгрузка в CSV / vCard / JSON Lines (см. ContactExporter);
+    // indices — например, результат find(), nullptr — все контакты
+    bool exportToFile(const std::string& fileName, ExportFormat format,
+                      const std::vector<std::size_t>* indices = nullptr) const;
+
+    // Интернирование строк: одинаковые ФИО и адреса хранятся один раз
+    // в пуле справочника. Включено по умолчанию.
+    void setStringInterning(bool enabled);
+    bool stringInterning() const { return m_interning; }
+
+    // Индекс триграмм для find() и findByPhone() (см. ContactIndex).
+    // Включён по умолчанию; строится при первом поиске, дальше обновляется
+    // вместе со справочником. Выключен — поиск просматривает ключи всех контактов.
+    void setSearchIndex(bool enabled);
+    bool searchIndex() const { return m_searchIndexing; }
+
+    // Потоки для поиска, которому индекс не помогает (ключи всех контактов):
+    // буфер ключей делится на части по записям, каждую просматривает свой
+    // поток, результаты склеиваются по порядку. 0 — по числу ядер, если ключей
+    // не меньше kParallelScanBytes, иначе один поток; 1 — всегда один.
+    static constexpr std::size_t kParallelScanBytes = std::size_t(1) << 20;
+    void setSearchThreads(unsigned threads) { m_searchThreads = threads; }
+    unsigned searchThreads() const { return m_searchThreads; }
+
+    // По полям: last_name, first_name, middle_name, address
+    std::vector<StringFieldStats> stringStats() const;
+
+    // Пустой справочник; режим интернирования сохраняется
+    void clear();
+
+    // Добавление и изменение по handle — O(1). Удаление сохраняет порядок
+    // (после sortBy справочник остаётся отсортированным): следующие контакты
+    // сдвигаются, их позиции в contacts() меняются, handle — нет.
+    ContactHandle addContact(const Contact& c);
+    ContactHandle addContact(Contact&& c);
+    bool removeContact(ContactHandle h);
+    bool updateContact(ContactHandle h, const Contact& c);
+    bool updateContact(ContactHandle h, Contact&& c);
+
+    // Контакт создаётся сразу в справочнике, из аргументов конструктора Contact
+    template <typename... Args>
+    ContactHandle emplaceContact(Args&&... args)
+    {
+        return added(m_contacts.emplace(std::forward<Args>(args)...));
+    }
+
+    // Пачка контактов: место резервируется один раз; из rvalue-контейнера
+    // контакты переносятся, а не копируются. handles — handle каждого добавленного.
+    template <typename Range>
+    void addContacts(Range&& range, std::vector<ContactHandle>* handles = nullptr)
+    {
+        const std::size_t count = static_cast<std::size_t>(std::distance(std::begin(range), std::end(range)));
+        reserve(m_contacts.size() + count);
+        if (handles)
+            handles->reserve(handles->size() + count);
+
+        for (auto& c : range)
+        {
+            ContactHandle h;
+            if constexpr (std::is_rvalue_reference_v<Range&&>)
+                h = added(m_contacts.emplace(std::move(c)));
+            else
+                h = added(m_contacts.emplace(c));
+            if (handles)
+                handles->push_back(h);
+        }
+    }
+
+    // Пачка добавлений, изменений и удалений: контакты переносятся,
+    // столбцы и пул строк обновляются, а contacts() после удалений
+    // сдвигается один раз на всю пачку.
+    // Изменения с устаревшим handle пропускаются; возвращает число применённых.
+    std::size_t applyChanges(std::vector<ContactChange>&& changes,
+                             std::vector<ContactHandle>* addedHandles = nullptr);
+
+    void reserve(std::size_t count) { m_contacts.reserve(count); }
+
+    // По позиции в contacts() (журнал изменений хранит позиции)
     bool removeContact(std::size_t index);
     bool updateContact(std::size_t index, const Contact& c);
+    bool updateContact(std::size_t index, Contact&& c);
+
+    const Contact* contact(ContactHandle h) const { return m_contacts.get(h); }
+    ContactHandle handleAt(std::size_t index) const { return m_contacts.handleAt(index); }
+    // Позиция в contacts(); SlotMap<Contact>::npos — контакт удалён
+    std::size_t indexOf(ContactHandle h) const { return m_contacts.indexOf(h); }
+
+    // Все контакты подряд, без пропусков
+    const std::vector<Contact>& contacts() const { return m_contacts.values(); }
 
-    const std::vector<Contact>& contacts() const { return m_contacts; }
+    // Те же контакты по столбцам (см. ContactStore); после изменений справочника
+    // перестраивается при первом обращении. На нём работают sortBy() и findByPhone() без индекса.
+    const ContactStore& columns() const;
 
+    // Индекс поиска; строится при первом обращении
+    const ContactIndex& index() const;
+
+    // Поиск без учёта регистра по всем полям (ФИО, адрес, email, телефоны),
+    // общий для поиска и фильтра таблицы; ФИО — и в другой раскладке
+    // («Ivanov» находит «Иванов», см. Translit); позиции в contacts() по возрастанию
     std::vector<std::size_t> find(const std::string& text) const;
+
+    // То же с отменой: запрос устарел (пользователь ввёл следующий) — другой
+    // поток ставит cancel, просмотр останавливается на ближайшей части буфера,
+    // перестройка индекса и буфера ключей после изменений — через несколько тысяч записей.
+    // false — поиск отменён, out пуст.
+    // Для вызова не из потока, который меняет справочник: пока идёт поиск,
+    // справочник менять нельзя. Так ищет строка поиска окна (через IncrementalSearch)
+    bool find(const std::string& text, std::vector<std::size_t>& out, const std::atomic<bool>& cancel) const;
+
+    // То же, что find(text), если previous — результат find(previousText),
+    // а previousText — начало text (ввод по буквам): проверяются только
+    // контакты из previous. Заново ищутся совпадения по номеру и транслитерации,
+    // если её ключ не продолжает ключ previousText
+    std::vector<std::size_t> refine(const std::vector<std::size_t>& previous,
+                                    const std::string& previousText,
+                                    const std::string& text) const;
+
+    // Меняется при каждом изменении справочника (и сортировке) —
+    // по нему видно, что сохранённые позиции и результаты поиска устарели
+    std::uint64_t revision() const { return m_revision; }
+
+    // Ключ поиска контакта (см. SearchKey); обновляется при каждом изменении
+    std::string_view searchKey(std::size_t index) const;
+
+    // Ключ транслитерации ФИО (см. Translit): по нему find() находит
+    // «Ivanov» по запросу «Иванов» и наоборот; строится вместе с ключом поиска
+    const TranslitKey& translitKey(std::size_t index) const;
+
+    // Запрос по полям (см. ContactQuery); позиции в contacts() по возрастанию.
+    // Кандидатов даёт самый избирательный индекс (см. planQuery), списки
+    // следующих пересекаются с ними, пока они не намного длиннее, остальные
+    // условия проверяются у каждого кандидата. Без индекса — у всех контактов.
+    std::vector<std::size_t> findQuery(const ContactQuery& query) const;
+    QueryPlan planQuery(const ContactQuery& query) const;
+
+    // Поиск по ФИО с опечатками («Иванав» находит «Иванов»): каждое слово
+    // запроса совпадает со словом фамилии, имени или отчества с точностью до
+    // maxTypos() правок (вставка, удаление, замена буквы). Не больше k лучших:
+    // меньше опечаток, затем совпадение в фамилии раньше имени, затем по позиции.
+    // Словарь ФИО (см. NameTrie) строится при первом вызове; новые контакты
+    // дописываются в него, после изменений и удалений он строится заново.
+    std::vector<FuzzyMatch> findFuzzy(const std::string& text, std::size_t k = 20) const;
+
+    // Сколько опечаток допускается в слове из letters букв
+    static unsigned maxTypos(std::size_t letters);
+
+    // Контакты с этим номером в любой записи («+7...», «8(...)...»)
+    std::vector<std::size_t> findByPhone(const std::string& number) const;
+
+    // Контакты, в номере которых есть эти цифры («812123», «123-45-67»):
+    // сравниваются только цифры канонического номера, оформление не важно.
+    // Handle в порядке contacts().
+    std::vector<ContactHandle> findByDigits(const std::string& fragment,
+                                            DigitMatch match = DigitMatch::Infix) const;
     void sortBy(SortField field, bool ascending = true);
 
 private:
-    std::vector<Contact> m_contacts;
+    bool loadFromStream(const std::string& fileName, std::vector<Contact>& out);
+    bool loadFromMapped(const std::string& fileName, std::vector<Contact>& out);
+    void setContacts(std::vector<Contact>&& contacts);
+
+    void internAll();
+    ContactHandle added(ContactHandle h);
+    void invalidateColumns() { m_columnsValid = false; }
+    void invalidateIndex();
+    void invalidateNames();
+    const NameTrie& names() const;
+    void setSearchKey(ContactHandle h);
+    void contactAdded(ContactHandle h);
+    void contactChanged(ContactHandle h);
+    bool updateKeyText(const std::atomic<bool>* cancel = nullptr) const;
+    const ContactIndex* buildIndex(const std::atomic<bool>* cancel) const;
+    bool matchesPhone(std::size_t index, std::uint64_t canonical) const;
+    bool matchesDigits(std::size_t index, std::string_view digits, DigitMatch match) const;
+    std::vector<std::size_t> digitMatches(std::string_view digits, DigitMatch match) const;
+    bool findInto(const std::string& text, std::vector<std::size_t>& out, const std::atomic<bool>* cancel) const;
+    bool scanKeys(const std::string& text, const std::vector<std::size_t>& offsets, std::string_view needle,
+                  std::vector<std::size_t>& out, const std::atomic<bool>* cancel) const;
+    bool addTranslitMatches(std::vector<std::size_t>& result, const std::string& text,
+                            const std::atomic<bool>* cancel) const;
+    std::vector<std::size_t> withPhoneMatches(std::vector<std::size_t> result, const std::string& text) const;
+    std::vector<std::size_t> stepMatches(const ContactQuery::Term& term, QueryPlan::Access access) const;
+    std::pair<std::size_t, std::size_t> birthRange(Date from, Date to) const;
+
+    SlotMap<Contact> m_contacts;
+
+    mutable ContactStore m_columns;
+    mutable bool         m_columnsValid = false;
+
+    mutable ContactIndex m_index;
+    mutable bool         m_indexValid = false;
+    bool                 m_searchIndexing = true;
+    unsigned             m_searchThreads = 0;
+
+    mutable NameTrie     m_names;
+    mutable bool         m_namesValid = false;
+
+    std::vector<std::string> m_searchKeys;   // SearchKey::build по номеру слота
+    std::vector<TranslitKey> m_translitKeys; // SearchKey::buildTranslit по номеру слота
+    std::uint64_t            m_revision = 0;
+
+    // Ключи (и ключи транслитерации) в порядке contacts() одной строкой —
+    // для SubstringScan; актуальны, пока m_keyTextRevision == m_revision
+    mutable std::string              m_keyText;
+    mutable std::vector<std::size_t> m_keyOffsets;
+    mutable std::string              m_translitText;
+    mutable std::vector<std::size_t> m_translitOffsets;
+    mutable std::uint64_t            m_keyTextRevision = static_cast<std::uint64_t>(-1);
+
+    // (Date::packed, позиция в contacts()) по возрастанию даты — для born:
+    mutable std::vector<std::pair<std::uint32_t, std::uint32_t>> m_birthOrder;
+    mutable std::uint64_t            m_birthOrderRevision = static_cast<std::uint64_t>(-1);
+
+    bool       m_interning = true;
+    StringPool m_pool;
 };
@@ -0,0 +1,347 @@
+#include "ContactExporter.h"
+#include <cctype>
+#include <string_view>
+#include <QSaveFile>
+#include <QString>
+
+namespace {
+
+void appendDate(std::string& out, const Date& d)
+{
+    char buf[Date::kIsoLength];
+    out.append(buf, static_cast<std::size_t>(d.formatIso(buf) - buf));
+}
+
+const char* phoneTypeName(PhoneType t)
+{
+    switch (t)
+    {
+    case PhoneType::Mobile: return "mobile";
+    case PhoneType::Home:   return "home";
+    case PhoneType::Work:   return "work";
+    case PhoneType::Other:  return "other";
+    }
+    return "other";
+}
+
+// --- CSV ------------------------------------------------------------
+
+// В кавычки — только если иначе поле прочитается не так
+void appendCsvField(std::string& out, const std::string& v)
+{
+    bool quote = !v.empty() && (v.front() == ' ' || v.back() == ' ');
+    for (char ch : v)
+    {
+        if (ch == ',' || ch == '"' || ch == '\n' || ch == '\r')
+        {
+            quote = true;
+            break;
+        }
+    }
+
+    if (!quote)
+    {
+        out += v;
+        return;
+    }
+
+    out += '"';
+    for (char ch : v)
+    {
+        if (ch == '"')
+            out += '"';
+        out += ch;
+    }
+    out += '"';
+}
+
+void appendCsv(std::string& out, const Contact& c)
+{
+    appendCsvField(out, c.lastName());
+    out += ',';
+    appendCsvField(out, c.firstName());
+    out += ',';
+    appendCsvField(out, c.middleName());
+    out += ',';
+    appendCsvField(out, c.address());
+    out += ',';
+    appendDate(out, c.birthDate());
+    out += ',';
+    appendCsvField(out, c.email());
+    out += ',';
+
+    // телефоны одной ячейкой: номер|тип;номер|тип
+    const auto& phones = c.phones();
+    for (std::size_t i = 0; i < phones.size(); ++i)
+    {
+        if (i != 0)
+            out += ';';
+        out += phones[i].number();
+        out += '|';
+        out += phoneTypeName(phones[i].type());
+    }
+
+    out += '\n';
+}
+
+// --- vCard ----------------------------------------------------------
+
+void appendVCardText(std::string& out, std::string_view v)
+{
+    for (char ch : v)
+    {
+        switch (ch)
+        {
+        case '\\': out += "\\\\"; break;
+        case ';':  out += "\\;";  break;
+        case ',':  out += "\\,";  break;
+        case '\n': out += "\\n";  break;
+        case '\r': break;
+        default:   out += ch;
+        }
+    }
+}
+
+// Строка длиннее 75 байт переносится (RFC 6350, 3.2), не разрывая символы UTF-8
+void foldVCardLine(std::string& out, std::size_t start)
+{
+    const std::size_t kMaxLine = 75;
+    if (out.size() - start <= kMaxLine)
+        return;
+
+    const std::string line = out.substr(start);
+    out.resize(start);
+
+    std::size_t pos = 0;
+    std::size_t limit = kMaxLine;
+    while (line.size() - pos > limit)
+    {
+        std::size_t cut = pos + limit;
+        while (cut > pos && (static_cast<unsigned char>(line[cut]) & 0xC0) == 0x80)
+            --cut;
+
+        out.append(line, pos, cut - pos);
+        out += "\r\n ";
+        pos = cut;
+        limit = kMaxLine - 1; // пробел продолжения тоже занимает место
+    }
+    out.append(line, pos, std::string::npos);
+}
+
+void appendVCard(std::string& out, const Contact& c)
+{
+    out += "BEGIN:VCARD\r\nVERSION:3.0\r\n";
+
+    std::size_t start = out.size();
+    out += "N:";
+    appendVCardText(out, c.lastName());
+    out += ';';
+    appendVCardText(out, c.firstName());
+    out += ';';
+    appendVCardText(out, c.middleName());
+    out += ";;";
+    foldVCardLine(out, start);
+    out += "\r\n";
+
+    start = out.size();
+    out += "FN:";
+    appendVCardText(out, c.firstName());
+    if (!c.middleName().empty())
+    {
+        out += ' ';
+        appendVCardText(out, c.middleName());
+    }
+    out += ' ';
+    appendVCardText(out, c.lastName());
+    foldVCardLine(out, start);
+    out += "\r\n";
+
+    if (!c.address().empty())
+    {
+        // адрес у нас одной строкой — целиком в поле «улица»
+        start = out.size();
+        out += "ADR:;;";
+        appendVCardText(out, c.address());
+        out += ";;;;";
+        foldVCardLine(out, start);
+        out += "\r\n";
+    }
+
+    out += "BDAY:";
+    appendDate(out, c.birthDate());
+    out += "\r\n";
+
+    start = out.size();
+    out += "EMAIL:";
+    appendVCardText(out, c.email());
+    foldVCardLine(out, start);
+    out += "\r\n";
+
+    for (const auto& ph : c.phones())
+    {
+        static const char* const types[] = { "CELL", "HOME", "WORK", "OTHER" };
+        start = out.size();
+        out += "TEL;TYPE=";
+        out += types[static_cast<int>(ph.type())];
+        out += ':';
+        appendVCardText(out, ph.number());
+        foldVCardLine(out, start);
+        out += "\r\n";
+    }
+
+    out += "END:VCARD\r\n";
+}
+
+// --- JSON Lines -----------------------------------------------------
+
+void appendJsonString(std::string& out, std::string_view v)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out += '"';
+    for (char ch : v)
+    {
+        const unsigned char u = static_cast<unsigned char>(ch);
+        switch (ch)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (u < 0x20)
+            {
+                out += "\\u00";
+                out += hex[u >> 4];
+                out += hex[u & 0x0F];
+            }
+            else
+                out += ch; // UTF-8 — как есть
+        }
+    }
+    out += '"';
+}
+
+void appendJson(std::string& out, const Contact& c)
+{
+    out += "{\"last_name\":";
+    appendJsonString(out, c.lastName());
+    out += ",\"first_name\":";
+    appendJsonString(out, c.firstName());
+    out += ",\"middle_name\":";
+    appendJsonString(out, c.middleName());
+    out += ",\"address\":";
+    appendJsonString(out, c.address());
+    out += ",\"birth_date\":\"";
+    appendDate(out, c.birthDate());
+    out += "\",\"email\":";
+    appendJsonString(out, c.email());
+    out += ",\"phones\":[";
+
+    const auto& phones = c.phones();
+    for (std::size_t i = 0; i < phones.size(); ++i)
+    {
+        if (i != 0)
+            out += ',';
+        out += "{\"number\":";
+        appendJsonString(out, phones[i].number());
+        out += ",\"type\":\"";
+        out += phoneTypeName(phones[i].type());
+        out += "\"}";
+    }
+
+    out += "]}\n";
+}
+
+} // namespace
+
+bool ContactExporter::formatFromFileName(const std::string& fileName, ExportFormat& format)
+{
+    const std::size_t dot = fileName.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+
+    std::string ext = fileName.substr(dot + 1);
+    for (auto& ch : ext)
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+
+    if (ext == "csv")
+        format = ExportFormat::Csv;
+    else if (ext == "vcf" || ext == "vcard")
+        format = ExportFormat::VCard;
+    else if (ext == "jsonl")
+        format = ExportFormat::JsonLines;
+    else
+        return false;
+    return true;
+}
+
+void ContactExporter::appendHeader(std::string& out, ExportFormat format)
+{
+    if (format == ExportFormat::Csv)
+        out += "last_name,first_name,middle_name,address,birth_date,email,phones\n";
+}
+
+void ContactExporter::appendRecord(std::string& out, const Contact& c, ExportFormat format)
+{
+    switch (format)
+    {
+    case ExportFormat::Csv:       appendCsv(out, c);   break;
+    case ExportFormat::VCard:     appendVCard(out, c); break;
+    case ExportFormat::JsonLines: appendJson(out, c);  break;
+    }
+}
+
+bool ContactExporter::exportFile(const std::vector<Contact>& contacts, const std::string& fileName,
+                                 ExportFormat format, const std::vector<std::size_t>* indices)
+{
+    QSaveFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    std::string buf;
+    buf.reserve(kChunkSize + 4096);
+
+    auto flush = [&]()
+    {
+        const qint64 n = static_cast<qint64>(buf.size());
+        const bool ok = file.write(buf.data(), n) == n;
+        buf.clear(); // ёмкость остаётся — буфер переиспользуется
+        return ok;
+    };
+
+    auto put = [&](const Contact& c)
+    {
+        appendRecord(buf, c, format);
+        return buf.size() < kChunkSize || flush();
+    };
+
+    appendHeader(buf, format);
+
+    bool ok = true;
+    if (indices)
+    {
+        for (std::size_t i : *indices)
+        {
+            if (i < contacts.size() && !(ok = put(contacts[i])))
+                break;
+        }
+    }
+    else
+    {
+        for (const auto& c : contacts)
+        {
+            if (!(ok = put(c)))
+                break;
+        }
+    }
+
+    if (!ok || !flush())
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
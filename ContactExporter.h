@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Contact.h"
+
+enum class ExportFormat {
+    Csv,
+    VCard,
+    JsonLines
+};
+
+// Выгрузка справочника для внешних систем.
+//
+// Записи сериализуются прямо из Contact в один переиспользуемый буфер
+// (без QString и QTextStream) и сбрасываются в файл кусками по kChunkSize,
+// так что расход памяти не зависит от размера справочника.
+// CSV читается обратно ContactImporter (те же колонки и запись телефонов).
+class ContactExporter
+{
+public:
+    static constexpr std::size_t kChunkSize = 1 << 20;
+
+    // По расширению: .csv / .vcf / .vcard / .jsonl
+    static bool formatFromFileName(const std::string& fileName, ExportFormat& format);
+
+    // indices — подмножество (например, результат ContactBook::find);
+    // nullptr — все контакты по порядку
+    static bool exportFile(const std::vector<Contact>& contacts, const std::string& fileName,
+                           ExportFormat format,
+                           const std::vector<std::size_t>* indices = nullptr);
+
+    // Заголовок файла (есть только у CSV) и одна запись — дописываются в out
+    static void appendHeader(std::string& out, ExportFormat format);
+    static void appendRecord(std::string& out, const Contact& c, ExportFormat format);
+};
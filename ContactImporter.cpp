@@ -0,0 +1,739 @@
+#include "ContactImporter.h"
+#include "Parallel.h"
+#include "Validator.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+#include <QFile>
+#include <QString>
+
+namespace {
+
+const qint64      kReadChunk     = 1 << 20;
+const std::size_t kValidateChunk = 256;
+
+std::string lowerAscii(std::string_view s)
+{
+    std::string r(s);
+    for (auto& ch : r)
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return r;
+}
+
+bool equalsNoCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && lowerAscii(a) == lowerAscii(b);
+}
+
+// Чтение файла по строкам через буфер; весь файл в память не попадает
+class LineReader
+{
+public:
+    explicit LineReader(QFile& file)
+        : m_file(file), m_buf(static_cast<std::size_t>(kReadChunk))
+    {
+    }
+
+    // Строка без \r\n; действительна до следующего вызова
+    bool next(std::string_view& line)
+    {
+        for (;;)
+        {
+            const char* begin = m_buf.data() + m_pos;
+            const char* nl = static_cast<const char*>(std::memchr(begin, '\n', m_len - m_pos));
+
+            if (nl || (m_eof && m_pos < m_len))
+            {
+                const char* end = nl ? nl : m_buf.data() + m_len;
+                m_pos = static_cast<std::size_t>(end - m_buf.data()) + (nl ? 1 : 0);
+                if (end > begin && end[-1] == '\r')
+                    --end;
+
+                // UTF-8 BOM в начале файла
+                if (m_line++ == 0 && end - begin >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+                    begin += 3;
+
+                line = std::string_view(begin, static_cast<std::size_t>(end - begin));
+                return true;
+            }
+
+            if (m_eof)
+                return false;
+            fill();
+        }
+    }
+
+    // Номер последней выданной строки (с 1)
+    std::size_t lineNumber() const { return m_line; }
+    bool failed() const { return m_failed; }
+
+private:
+    void fill()
+    {
+        // непрочитанный хвост — в начало буфера
+        if (m_pos > 0)
+        {
+            std::memmove(m_buf.data(), m_buf.data() + m_pos, m_len - m_pos);
+            m_len -= m_pos;
+            m_pos = 0;
+        }
+
+        // строка не поместилась в буфер целиком
+        if (m_len == m_buf.size())
+            m_buf.resize(m_buf.size() * 2);
+
+        const qint64 n = m_file.read(m_buf.data() + m_len,
+                                     static_cast<qint64>(m_buf.size() - m_len));
+        if (n <= 0)
+        {
+            m_failed = n < 0;
+            m_eof = true;
+            return;
+        }
+        m_len += static_cast<std::size_t>(n);
+    }
+
+    QFile&            m_file;
+    std::vector<char> m_buf;
+    std::size_t       m_pos = 0;
+    std::size_t       m_len = 0;
+    std::size_t       m_line = 0;
+    bool              m_eof = false;
+    bool              m_failed = false;
+};
+
+// Запись, ожидающая проверки
+struct Pending
+{
+    std::size_t line = 0;
+    Contact     contact;
+    std::string error;
+
+    void reset(std::size_t at)
+    {
+        line = at;
+        contact = Contact();
+        error.clear();
+    }
+};
+
+// ГГГГ-ММ-ДД, ДД.ММ.ГГГГ или ГГГГММДД; иначе — недействительная дата
+Date parseDate(const std::string& raw)
+{
+    const std::string s = Validator::trim(raw.substr(0, raw.find('T')));
+
+    auto digits = [&](std::size_t from, std::size_t count, int& value)
+    {
+        value = 0;
+        for (std::size_t i = from; i < from + count; ++i)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(s[i])))
+                return false;
+            value = value * 10 + (s[i] - '0');
+        }
+        return true;
+    };
+
+    Date d;
+    if (Date::parseIso(s, d))
+        return d;
+
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    bool ok = false;
+    if (s.size() == 10 && s[2] == '.' && s[5] == '.')
+        ok = digits(6, 4, year) && digits(3, 2, month) && digits(0, 2, day);
+    else if (s.size() == 8)
+        ok = digits(0, 4, year) && digits(4, 2, month) && digits(6, 2, day);
+
+    return ok ? Date(year, month, day) : Date{};
+}
+
+PhoneType phoneTypeFromName(const std::string& name)
+{
+    if (name.empty() || name == "cell" || name == "mobile")
+        return PhoneType::Mobile;
+    return PhoneNumber::stringToType(name);
+}
+
+// --- CSV ------------------------------------------------------------
+
+enum Column { ColLastName, ColFirstName, ColMiddleName, ColAddress,
+              ColBirthDate, ColEmail, ColPhones, ColumnCount };
+
+int columnByName(const std::string& raw)
+{
+    // регистр и разделители слов не важны: Last Name, last_name, lastname
+    std::string name;
+    for (char ch : lowerAscii(Validator::trim(raw)))
+    {
+        if (ch != ' ' && ch != '_' && ch != '-')
+            name += ch;
+    }
+
+    static const struct { const char* name; Column column; } names[] = {
+        { "lastname", ColLastName },     { "surname", ColLastName },
+        { "familyname", ColLastName },   { "Фамилия", ColLastName },
+        { "фамилия", ColLastName },
+        { "firstname", ColFirstName },   { "givenname", ColFirstName },
+        { "Имя", ColFirstName },         { "имя", ColFirstName },
+        { "middlename", ColMiddleName }, { "patronymic", ColMiddleName },
+        { "Отчество", ColMiddleName },   { "отчество", ColMiddleName },
+        { "address", ColAddress },       { "Адрес", ColAddress },
+        { "адрес", ColAddress },
+        { "birthdate", ColBirthDate },   { "birthday", ColBirthDate },
+        { "bday", ColBirthDate },        { "dateofbirth", ColBirthDate },
+        { "Датарождения", ColBirthDate },{ "датарождения", ColBirthDate },
+        { "email", ColEmail },           { "mail", ColEmail },
+        { "phones", ColPhones },         { "phone", ColPhones },
+        { "tel", ColPhones },            { "telephone", ColPhones },
+        { "Телефоны", ColPhones },       { "телефоны", ColPhones },
+        { "Телефон", ColPhones },        { "телефон", ColPhones },
+    };
+
+    for (const auto& n : names)
+    {
+        if (name == n.name)
+            return n.column;
+    }
+    return -1;
+}
+
+class CsvSource
+{
+public:
+    explicit CsvSource(LineReader& reader) : m_reader(reader)
+    {
+        for (auto& c : m_columns)
+            c = -1;
+    }
+
+    bool readHeader(std::string& error)
+    {
+        std::string_view line;
+        if (!nextNonEmpty(line))
+        {
+            error = "Пустой файл.";
+            return false;
+        }
+
+        // разделитель — тот, которого в заголовке больше всего
+        std::size_t best = 0;
+        for (char d : { ',', ';', '\t' })
+        {
+            const std::size_t n = static_cast<std::size_t>(std::count(line.begin(), line.end(), d));
+            if (n > best)
+            {
+                best = n;
+                m_delim = d;
+            }
+        }
+
+        parseRecord(line);
+        for (std::size_t i = 0; i < m_fields.size(); ++i)
+        {
+            const int col = columnByName(m_fields[i]);
+            if (col >= 0 && m_columns[col] < 0)
+                m_columns[col] = static_cast<int>(i);
+        }
+
+        if (m_columns[ColLastName] < 0 || m_columns[ColFirstName] < 0)
+        {
+            error = "В заголовке CSV нет колонок фамилии и имени.";
+            return false;
+        }
+        return true;
+    }
+
+    bool next(Pending& p)
+    {
+        std::string_view line;
+        if (!nextNonEmpty(line))
+            return false;
+
+        p.reset(m_reader.lineNumber());
+        if (!parseRecord(line))
+            p.error = "Незакрытые кавычки.";
+
+        Contact& c = p.contact;
+        c.setLastName(field(ColLastName));
+        c.setFirstName(field(ColFirstName));
+        c.setMiddleName(field(ColMiddleName));
+        c.setAddress(field(ColAddress));
+        c.setBirthDate(parseDate(field(ColBirthDate)));
+        c.setEmail(field(ColEmail));
+
+        const std::string phones = field(ColPhones);
+        std::size_t start = 0;
+        while (start <= phones.size())
+        {
+            std::size_t end = phones.find(';', start);
+            if (end == std::string::npos)
+                end = phones.size();
+
+            const std::string item = Validator::trim(phones.substr(start, end - start));
+            if (!item.empty())
+            {
+                const std::size_t bar = item.find('|');
+                const std::string number = Validator::trim(item.substr(0, bar));
+                const std::string type = bar == std::string::npos
+                    ? std::string() : lowerAscii(Validator::trim(item.substr(bar + 1)));
+                c.addPhone(PhoneNumber(number, phoneTypeFromName(type)));
+            }
+            start = end + 1;
+        }
+
+        return true;
+    }
+
+private:
+    bool nextNonEmpty(std::string_view& line)
+    {
+        while (m_reader.next(line))
+        {
+            for (char ch : line)
+            {
+                if (!std::isspace(static_cast<unsigned char>(ch)))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Поля записи в m_fields; запись в кавычках может продолжаться на следующих строках.
+    // false — файл кончился внутри кавычек
+    bool parseRecord(std::string_view line)
+    {
+        m_fields.clear();
+        std::string field;
+        bool quoted = false;
+
+        for (;;)
+        {
+            for (std::size_t i = 0; i < line.size(); ++i)
+            {
+                const char ch = line[i];
+                if (quoted)
+                {
+                    if (ch != '"')
+                        field += ch;
+                    else if (i + 1 < line.size() && line[i + 1] == '"')
+                        field += line[++i];
+                    else
+                        quoted = false;
+                }
+                else if (ch == '"')
+                    quoted = true;
+                else if (ch == m_delim)
+                {
+                    m_fields.push_back(std::move(field));
+                    field.clear();
+                }
+                else
+                    field += ch;
+            }
+
+            if (!quoted)
+                break;
+
+            if (!m_reader.next(line))
+            {
+                m_fields.push_back(std::move(field));
+                return false;
+            }
+            field += '\n';
+        }
+
+        m_fields.push_back(std::move(field));
+        return true;
+    }
+
+    std::string field(Column col) const
+    {
+        const int i = m_columns[col];
+        if (i < 0 || static_cast<std::size_t>(i) >= m_fields.size())
+            return std::string();
+        return Validator::trim(m_fields[static_cast<std::size_t>(i)]);
+    }
+
+    LineReader&              m_reader;
+    char                     m_delim = ',';
+    int                      m_columns[ColumnCount];
+    std::vector<std::string> m_fields;
+};
+
+// --- vCard ----------------------------------------------------------
+
+// \n \, \; \\ → символы
+std::string unescapeVCard(std::string_view s)
+{
+    std::string r;
+    r.reserve(s.size());
+    for (std::size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '\\' && i + 1 < s.size())
+        {
+            const char ch = s[++i];
+            r += (ch == 'n' || ch == 'N') ? ' ' : ch;
+        }
+        else
+            r += s[i];
+    }
+    return r;
+}
+
+// Компоненты структурного значения (N, ADR), разделённые неэкранированной ';'
+std::vector<std::string> splitVCard(std::string_view s)
+{
+    std::vector<std::string> parts;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= s.size(); ++i)
+    {
+        if (i < s.size() && s[i] == '\\')
+        {
+            ++i;
+            continue;
+        }
+        if (i == s.size() || s[i] == ';')
+        {
+            parts.push_back(Validator::trim(unescapeVCard(s.substr(start, i - start))));
+            start = i + 1;
+        }
+    }
+    return parts;
+}
+
+std::string decodeQuotedPrintable(std::string_view s)
+{
+    auto hex = [](char ch) -> int
+    {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        return -1;
+    };
+
+    std::string r;
+    for (std::size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '=' && i + 2 < s.size() && hex(s[i + 1]) >= 0 && hex(s[i + 2]) >= 0)
+        {
+            r += static_cast<char>(hex(s[i + 1]) * 16 + hex(s[i + 2]));
+            i += 2;
+        }
+        else
+            r += s[i];
+    }
+    return r;
+}
+
+class VCardSource
+{
+public:
+    explicit VCardSource(LineReader& reader) : m_reader(reader) {}
+
+    bool next(Pending& p)
+    {
+        std::string line;
+        std::size_t at = 0;
+
+        // BEGIN:VCARD уже прочитан, если у предыдущей карточки не было END
+        if (m_beginLine == 0)
+        {
+            do
+            {
+                if (!nextLogical(line, at))
+                    return false;
+            } while (!equalsNoCase(Validator::trim(line), "BEGIN:VCARD"));
+            m_beginLine = at;
+        }
+
+        p.reset(m_beginLine);
+        m_beginLine = 0;
+
+        for (;;)
+        {
+            if (!nextLogical(line, at))
+            {
+                p.error = "Нет END:VCARD.";
+                return true;
+            }
+
+            const std::string trimmed = Validator::trim(line);
+            if (equalsNoCase(trimmed, "END:VCARD"))
+                return true;
+
+            if (equalsNoCase(trimmed, "BEGIN:VCARD"))
+            {
+                p.error = "Нет END:VCARD.";
+                m_beginLine = at;
+                return true;
+            }
+
+            applyProperty(line, p.contact);
+        }
+    }
+
+private:
+    // Логическая строка: продолжения (начинаются с пробела или табуляции) склеиваются
+    bool nextLogical(std::string& out, std::size_t& at)
+    {
+        if (!m_hasHeld)
+        {
+            std::string_view l;
+            if (!m_reader.next(l))
+                return false;
+            m_held.assign(l.data(), l.size());
+            m_heldLine = m_reader.lineNumber();
+        }
+
+        out.swap(m_held);
+        at = m_heldLine;
+        m_hasHeld = false;
+
+        std::string_view l;
+        while (m_reader.next(l))
+        {
+            if (!l.empty() && (l[0] == ' ' || l[0] == '\t'))
+            {
+                out.append(l.data() + 1, l.size() - 1);
+                continue;
+            }
+            m_held.assign(l.data(), l.size());
+            m_heldLine = m_reader.lineNumber();
+            m_hasHeld = true;
+            break;
+        }
+        return true;
+    }
+
+    void applyProperty(const std::string& line, Contact& c)
+    {
+        const std::size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            return;
+
+        // ИМЯ;ПАРАМЕТР;ПАРАМЕТР=ЗНАЧЕНИЕ:значение
+        std::vector<std::string> params;
+        std::size_t start = 0;
+        for (std::size_t i = 0; i <= colon; ++i)
+        {
+            if (i == colon || line[i] == ';')
+            {
+                params.push_back(lowerAscii(std::string_view(line).substr(start, i - start)));
+                start = i + 1;
+            }
+        }
+
+        std::string name = params.front();
+        params.erase(params.begin());
+        const std::size_t dot = name.rfind('.');   // группа: item1.TEL
+        if (dot != std::string::npos)
+            name.erase(0, dot + 1);
+
+        std::string value = line.substr(colon + 1);
+        for (const auto& prm : params)
+        {
+            if (prm == "encoding=quoted-printable" || prm == "quoted-printable")
+                value = decodeQuotedPrintable(value);
+        }
+
+        if (name == "n")
+        {
+            const auto parts = splitVCard(value);
+            c.setLastName(parts.size() > 0 ? parts[0] : std::string());
+            c.setFirstName(parts.size() > 1 ? parts[1] : std::string());
+            c.setMiddleName(parts.size() > 2 ? parts[2] : std::string());
+        }
+        else if (name == "adr" && c.address().empty())
+        {
+            std::string address;
+            for (const auto& part : splitVCard(value))
+            {
+                if (part.empty())
+                    continue;
+                if (!address.empty())
+                    address += ", ";
+                address += part;
+            }
+            c.setAddress(address);
+        }
+        else if (name == "bday")
+        {
+            c.setBirthDate(parseDate(unescapeVCard(value)));
+        }
+        else if (name == "email" && c.email().empty())
+        {
+            c.setEmail(Validator::trim(unescapeVCard(value)));
+        }
+        else if (name == "tel")
+        {
+            std::string number = Validator::trim(unescapeVCard(value));
+            if (equalsNoCase(std::string_view(number).substr(0, 4), "tel:"))
+                number.erase(0, 4);
+            c.addPhone(PhoneNumber(number, phoneType(params)));
+        }
+    }
+
+    // TYPE=cell,voice / TYPE=home / 2.1: ;CELL;VOICE
+    static PhoneType phoneType(const std::vector<std::string>& params)
+    {
+        bool other = false;
+        for (const auto& prm : params)
+        {
+            std::string_view v(prm);
+            if (v.substr(0, 5) == "type=")
+                v.remove_prefix(5);
+            else if (prm.find('=') != std::string::npos)
+                continue;
+
+            std::size_t start = 0;
+            while (start <= v.size())
+            {
+                std::size_t end = v.find(',', start);
+                if (end == std::string_view::npos)
+                    end = v.size();
+
+                std::string t(v.substr(start, end - start));
+                if (!t.empty() && t.front() == '"')
+                    t.erase(0, 1);
+                if (!t.empty() && t.back() == '"')
+                    t.pop_back();
+
+                if (t == "cell" || t == "mobile")
+                    return PhoneType::Mobile;
+                if (t == "home")
+                    return PhoneType::Home;
+                if (t == "work")
+                    return PhoneType::Work;
+                if (!t.empty() && t != "voice" && t != "pref")
+                    other = true;
+
+                start = end + 1;
+            }
+        }
+        return other ? PhoneType::Other : PhoneType::Mobile;
+    }
+
+    LineReader& m_reader;
+    std::string m_held;
+    std::size_t m_heldLine = 0;
+    bool        m_hasHeld = false;
+    std::size_t m_beginLine = 0;
+};
+
+} // namespace
+
+bool ContactImporter::formatFromFileName(const std::string& fileName, ImportFormat& format)
+{
+    const std::size_t dot = fileName.rfind('.');
+    if (dot == std::string::npos)
+        return false;
+
+    const std::string ext = lowerAscii(std::string_view(fileName).substr(dot + 1));
+    if (ext == "csv")
+    {
+        format = ImportFormat::Csv;
+        return true;
+    }
+    if (ext == "vcf" || ext == "vcard")
+    {
+        format = ImportFormat::VCard;
+        return true;
+    }
+    return false;
+}
+
+bool ContactImporter::importFile(const std::string& fileName, ImportFormat format,
+                                 const BatchHandler& onBatch, const RejectHandler& onReject,
+                                 Stats* stats, std::size_t batchSize, unsigned threads)
+{
+    Stats local;
+    Stats& st = stats ? *stats : local;
+    st = Stats{};
+
+    auto reject = [&](std::size_t line, const std::string& reason)
+    {
+        ++st.rejected;
+        if (onReject)
+            onReject(Rejection{line, reason});
+    };
+
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    LineReader reader(file);
+    CsvSource csv(reader);
+    VCardSource vcard(reader);
+
+    if (format == ImportFormat::Csv)
+    {
+        std::string error;
+        if (!csv.readHeader(error))
+        {
+            reject(reader.lineNumber(), error);
+            return false;
+        }
+    }
+
+    if (batchSize == 0)
+        batchSize = kDefaultBatchSize;
+
+    // одна порция на весь импорт: память не растёт с размером файла
+    std::vector<Pending> pending(batchSize);
+
+    // «сегодня» для дат рождения — один раз на импорт, в этом потоке
+    const Date today = Validator::today();
+
+    auto flush = [&](std::size_t count)
+    {
+        // проверки (регулярные выражения) — самая дорогая часть, раздаём их пулу
+        const std::size_t chunks = (count + kValidateChunk - 1) / kValidateChunk;
+        Parallel::forEach(chunks, [&](std::size_t chunk)
+        {
+            const std::size_t end = std::min(count, (chunk + 1) * kValidateChunk);
+            for (std::size_t i = chunk * kValidateChunk; i < end; ++i)
+            {
+                if (pending[i].error.empty())
+                    Validator::isValidContact(pending[i].contact, today, &pending[i].error);
+            }
+        }, threads);
+
+        std::vector<Contact> batch;
+        batch.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (pending[i].error.empty())
+                batch.push_back(std::move(pending[i].contact));
+            else
+                reject(pending[i].line, pending[i].error);
+        }
+
+        st.accepted += batch.size();
+        return batch.empty() || onBatch(std::move(batch));
+    };
+
+    std::size_t count = 0;
+    for (;;)
+    {
+        const bool more = format == ImportFormat::Csv ? csv.next(pending[count])
+                                                      : vcard.next(pending[count]);
+        if (!more)
+            break;
+
+        if (++count == batchSize)
+        {
+            if (!flush(count))
+                return false;
+            count = 0;
+        }
+    }
+
+    if (count > 0 && !flush(count))
+        return false;
+
+    return !reader.failed();
+}
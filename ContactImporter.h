@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Contact.h"
+
+enum class ImportFormat {
+    Csv,
+    VCard
+};
+
+// Потоковый импорт чужих выгрузок (CSV, vCard) без перевода в формат CONTACT.
+//
+// Файл читается кусками, в памяти одновременно только одна порция записей:
+// разобранные контакты проверяются Validator на пуле потоков, прошедшие проверку
+// отдаются пачкой в onBatch, отклонённые — по одной в onReject с номером строки.
+//
+// CSV: первая строка — заголовок. Колонки узнаются по именам
+// (last_name, first_name, middle_name, address, birth_date, email, phones
+// или как в таблице: Фамилия, Имя, ...), лишние пропускаются.
+// Разделитель — ',', ';' или табуляция, определяется по заголовку.
+// Поля в кавычках могут содержать разделитель и переводы строк.
+// Телефоны в одной ячейке через ';', тип — после '|': +79990001122|home
+//
+// vCard 2.1/3.0/4.0: N, ADR, BDAY, EMAIL, TEL (тип из TYPE=cell/home/work).
+class ContactImporter
+{
+public:
+    struct Rejection
+    {
+        std::size_t line = 0;   // строка начала записи (с 1)
+        std::string reason;
+    };
+
+    struct Stats
+    {
+        std::size_t accepted = 0;
+        std::size_t rejected = 0;
+    };
+
+    // onBatch вернул false → импорт прерывается
+    using BatchHandler  = std::function<bool(std::vector<Contact>&& batch)>;
+    using RejectHandler = std::function<void(const Rejection& r)>;
+
+    static constexpr std::size_t kDefaultBatchSize = 10000;
+
+    // По расширению: .csv / .vcf / .vcard
+    static bool formatFromFileName(const std::string& fileName, ImportFormat& format);
+
+    // false — файл не открылся, нет заголовка CSV или импорт прерван
+    static bool importFile(const std::string& fileName, ImportFormat format,
+                           const BatchHandler& onBatch, const RejectHandler& onReject,
+                           Stats* stats = nullptr,
+                           std::size_t batchSize = kDefaultBatchSize,
+                           unsigned threads = 0);
+};
@@ -0,0 +1,263 @@
+#include "ContactIndex.h"
+#include <algorithm>
+
+namespace {
+
+// Хвост номера (до 15 цифр) одним числом с тем же порядком, что у строк:
+// цифра d → полубайт d + 1, с начала старших разрядов, недостающие — 0
+// (короче — значит меньше, как у строк)
+std::uint64_t suffixOrder(std::string_view digits)
+{
+    std::uint64_t key = 0;
+    int shift = 60;
+    for (char ch : digits)
+    {
+        shift -= 4;
+        key |= std::uint64_t(ch - '0' + 1) << shift;
+    }
+    return key;
+}
+
+// Триграммы ключа транслитерации — с этими битами, их списки отдельные
+constexpr std::uint32_t kTranslitTag = std::uint32_t(1) << 24;
+constexpr std::uint32_t kLatinTag    = std::uint32_t(1) << 25;
+
+std::uint32_t translitTag(Translit::Script script)
+{
+    switch (script)
+    {
+    case Translit::Script::Latin:    return kTranslitTag | kLatinTag;
+    case Translit::Script::Cyrillic: return kTranslitTag;
+    default:                         return 0;
+    }
+}
+
+std::uint32_t gramAt(const char* p)
+{
+    return (std::uint32_t(static_cast<unsigned char>(p[0])) << 16)
+         | (std::uint32_t(static_cast<unsigned char>(p[1])) << 8)
+         |  std::uint32_t(static_cast<unsigned char>(p[2]));
+}
+
+} // namespace
+
+void ContactIndex::collectGrams(std::string_view text, std::uint32_t tag, std::vector<std::uint32_t>& grams)
+{
+    for (std::size_t i = 0; i + kGram <= text.size(); ++i)
+        grams.push_back(gramAt(text.data() + i) | tag);
+}
+
+void ContactIndex::insert(Postings& list, std::uint32_t doc)
+{
+    // обычно документ новый и больше всех — дописывается в конец;
+    // слот удалённого контакта может вернуться — тогда вставка в середину
+    if (list.empty() || list.back() < doc)
+    {
+        list.push_back(doc);
+        return;
+    }
+    if (list.back() == doc)
+        return;
+    auto it = std::lower_bound(list.begin(), list.end(), doc);
+    if (*it != doc)
+        list.insert(it, doc);
+}
+
+void ContactIndex::add(std::uint32_t doc, std::string_view key, const TranslitKey& translit,
+                       const Contact& c, bool bulk)
+{
+    for (const auto& ph : c.phones())
+    {
+        const std::uint64_t canonical = ph.canonical();
+        if (canonical == 0)
+            continue;
+        insert(m_phones[canonical], doc);
+
+        char digits[PhoneNumber::kMaxDigits];
+        m_numberDigits.append(digits, PhoneNumber::digits(canonical, digits));
+        m_numberStart.push_back(static_cast<std::uint32_t>(m_numberDigits.size()));
+        m_numberDoc.push_back(doc);
+    }
+    if (!bulk && m_numberDoc.size() - m_sortedNumbers >= kPendingNumbers)
+        flushNumbers();
+
+    addGrams(doc, key, 0);
+    if (translit.script != Translit::Script::None)
+        addGrams(doc, translit.text, translitTag(translit.script)); // без букв ключ не нужен
+}
+
+void ContactIndex::addGrams(std::uint32_t doc, std::string_view text, std::uint32_t tag)
+{
+    // повтор триграммы в том же ключе insert() отбросит сам
+    for (std::size_t i = 0; i + kGram <= text.size(); ++i)
+    {
+        Postings& list = m_grams[gramAt(text.data() + i) | tag];
+        const std::size_t before = list.size();
+        insert(list, doc);
+        m_postings += list.size() - before;
+    }
+}
+
+void ContactIndex::clear()
+{
+    m_grams.clear();
+    m_phones.clear();
+    m_numberDigits.clear();
+    m_numberStart.assign(1, 0);
+    m_numberDoc.clear();
+    m_suffixes.clear();
+    m_sortedNumbers = 0;
+    m_postings = 0;
+    m_stale = 0;
+}
+
+bool ContactIndex::candidates(std::string_view needle, std::vector<std::uint32_t>& out,
+                              Translit::Script translitOf) const
+{
+    out.clear();
+    if (needle.size() < kGram)
+        return false;
+
+    std::vector<std::uint32_t> grams;
+    collectGrams(needle, translitTag(translitOf), grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+    std::vector<const Postings*> lists;
+    lists.reserve(grams.size());
+    for (std::uint32_t g : grams)
+    {
+        auto it = m_grams.find(g);
+        if (it == m_grams.end())
+            return true; // такой триграммы нет ни у кого
+        lists.push_back(&it->second);
+    }
+
+    // начинаем с самого короткого списка — кандидатов меньше всего,
+    // по остальным спискам дальше идём двоичным поиском
+    std::sort(lists.begin(), lists.end(),
+              [](const Postings* a, const Postings* b) { return a->size() < b->size(); });
+
+    out = *lists.front();
+    for (std::size_t k = 1; k < lists.size() && !out.empty(); ++k)
+    {
+        const Postings& list = *lists[k];
+        auto from = list.begin();
+        std::size_t kept = 0;
+        for (std::uint32_t doc : out)
+        {
+            from = std::lower_bound(from, list.end(), doc);
+            if (from == list.end())
+                break;
+            if (*from == doc)
+                out[kept++] = doc;
+        }
+        out.resize(kept);
+    }
+    return true;
+}
+
+std::size_t ContactIndex::candidateBound(std::string_view needle, Translit::Script translitOf) const
+{
+    if (needle.size() < kGram)
+        return static_cast<std::size_t>(-1);
+
+    const std::uint32_t tag = translitTag(translitOf);
+    std::size_t bound = static_cast<std::size_t>(-1);
+    for (std::size_t i = 0; i + kGram <= needle.size() && bound != 0; ++i)
+    {
+        auto it = m_grams.find(gramAt(needle.data() + i) | tag);
+        bound = std::min(bound, it == m_grams.end() ? 0 : it->second.size());
+    }
+    return bound;
+}
+
+const std::vector<std::uint32_t>* ContactIndex::phoneDocs(std::uint64_t canonical) const
+{
+    auto it = m_phones.find(canonical);
+    return it == m_phones.end() ? nullptr : &it->second;
+}
+
+std::string_view ContactIndex::number(std::size_t n) const
+{
+    return std::string_view(m_numberDigits).substr(m_numberStart[n], m_numberStart[n + 1] - m_numberStart[n]);
+}
+
+std::string_view ContactIndex::suffix(std::uint32_t entry) const
+{
+    return number(entry >> 4).substr(entry & 0x0F);
+}
+
+void ContactIndex::flushNumbers()
+{
+    // новые хвосты сортируются по числовому ключу — это быстрее сравнения строк
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> added;
+    for (std::size_t n = m_sortedNumbers; n < m_numberDoc.size(); ++n)
+    {
+        const std::string_view digits = number(n);
+        for (std::size_t start = 0; start < digits.size(); ++start)
+            added.emplace_back(suffixOrder(digits.substr(start)), static_cast<std::uint32_t>(n << 4 | start));
+    }
+    m_sortedNumbers = m_numberDoc.size();
+    std::sort(added.begin(), added.end());
+
+    const std::size_t sorted = m_suffixes.size();
+    m_suffixes.reserve(sorted + added.size());
+    for (const auto& a : added)
+        m_suffixes.push_back(a.second);
+
+    std::inplace_merge(m_suffixes.begin(), m_suffixes.begin() + static_cast<long>(sorted), m_suffixes.end(),
+                       [this](std::uint32_t a, std::uint32_t b) { return suffix(a) < suffix(b); });
+}
+
+std::pair<std::size_t, std::size_t> ContactIndex::suffixRange(std::string_view digits) const
+{
+    // хвосты, начинающиеся с digits, — один отрезок массива
+    auto head = [&](std::uint32_t entry) { return suffix(entry).substr(0, digits.size()); };
+    auto from = std::lower_bound(m_suffixes.begin(), m_suffixes.end(), digits,
+                                 [&](std::uint32_t entry, std::string_view d) { return head(entry) < d; });
+    auto to = std::upper_bound(from, m_suffixes.end(), digits,
+                               [&](std::string_view d, std::uint32_t entry) { return d < head(entry); });
+    return { static_cast<std::size_t>(from - m_suffixes.begin()), static_cast<std::size_t>(to - m_suffixes.begin()) };
+}
+
+std::size_t ContactIndex::digitBound(std::string_view digits) const
+{
+    const auto range = suffixRange(digits);
+    return range.second - range.first + (m_numberDoc.size() - m_sortedNumbers);
+}
+
+void ContactIndex::findDigits(std::string_view digits, DigitMatch match,
+                              std::vector<std::uint32_t>& out) const
+{
+    out.clear();
+    if (digits.empty())
+        return;
+
+    const auto range = suffixRange(digits);
+    for (std::size_t k = range.first; k < range.second; ++k)
+    {
+        const std::uint32_t entry = m_suffixes[k];
+        const std::size_t start = entry & 0x0F;
+        if ((match == DigitMatch::Prefix && start != 0)
+            || (match == DigitMatch::Suffix && suffix(entry).size() != digits.size()))
+            continue;
+        out.push_back(m_numberDoc[entry >> 4]);
+    }
+
+    // ещё не влитые номера — подряд
+    for (std::size_t n = m_sortedNumbers; n < m_numberDoc.size(); ++n)
+    {
+        const std::string_view s = number(n);
+        const std::size_t pos = match == DigitMatch::Suffix && s.size() >= digits.size()
+                                    ? s.size() - digits.size() : 0;
+        const bool hit = match == DigitMatch::Infix
+                             ? s.find(digits) != std::string_view::npos
+                             : s.size() >= digits.size() && s.compare(pos, digits.size(), digits) == 0;
+        if (hit)
+            out.push_back(m_numberDoc[n]);
+    }
+
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
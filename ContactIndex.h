@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Contact.h"
+#include "SearchKey.h"
+
+// Где в номере должны стоять цифры запроса
+enum class DigitMatch {
+    Prefix,   // номер начинается с них
+    Suffix,   // заканчивается ими
+    Infix     // в любом месте
+};
+
+// Обратный индекс триграмм для поиска подстроки.
+//
+// Для каждых трёх подряд идущих байт ключа поиска контакта (см. SearchKey:
+// все поля в сложенном регистре) хранится упорядоченный список документов,
+// где они встречаются; триграммы ключа транслитерации (TranslitKey) — отдельно
+// от них, со своими списками для контактов с ФИО латиницей и кириллицей.
+// Сложенный запрос длиной от трёх байт разбивается на триграммы, их списки
+// пересекаются — получаются кандидаты, которые остаётся проверить обычным
+// поиском подстроки в ключе.
+// Для телефонов ещё и список по каноническому ключу номера
+// (PhoneNumber::canonical) — поиск номера в любой записи за O(1),
+// и суффиксный массив по цифрам канонических номеров: все «хвосты» цифр
+// всех номеров, упорядоченные как строки. Хвосты, начинающиеся с цифр
+// запроса, лежат в нём одним отрезком, который находится двоичным поиском, —
+// так ищутся куски номера («1234567», «812123») в любой записи.
+// Новые номера сначала копятся в конце и просматриваются подряд, пока их
+// не наберётся kPendingNumbers, — тогда их хвосты вливаются в массив.
+//
+// Документ — номер слота контакта в справочнике (SlotHandle::slot): он не
+// меняется при сортировке и удалении других контактов. Из списков документы
+// не удаляются — удалённый или изменённый контакт оставляет «устаревшие»
+// вхождения, их отсеивает проверка кандидатов. staleCount() подсказывает,
+// когда индекс пора построить заново.
+class ContactIndex
+{
+public:
+    static constexpr std::size_t kGram = 3;
+    static constexpr std::size_t kPendingNumbers = 4096;
+
+    // key — SearchKey::build(c), translit — SearchKey::buildTranslit(c).
+    // bulk — полное построение: номера вливаются в суффиксный массив
+    // не порциями, а одним flushNumbers() в конце
+    void add(std::uint32_t doc, std::string_view key, const TranslitKey& translit,
+             const Contact& c, bool bulk = false);
+
+    // Контакт удалён или изменён: его прежние вхождения устарели
+    void markStale() { ++m_stale; }
+    std::size_t staleCount() const { return m_stale; }
+
+    void clear();
+
+    // Документы, где есть все триграммы needle (по возрастанию);
+    // translitOf — искать в ключах транслитерации контактов с ФИО этим письмом
+    // (needle — Translit::key); None — в ключах поиска.
+    // false — needle короче kGram, индекс тут не помогает.
+    bool candidates(std::string_view needle, std::vector<std::uint32_t>& out,
+                    Translit::Script translitOf = Translit::Script::None) const;
+
+    // Сколько кандидатов candidates() переберёт самое большее (длина самого
+    // короткого списка); SIZE_MAX — needle короче kGram
+    std::size_t candidateBound(std::string_view needle, Translit::Script translitOf = Translit::Script::None) const;
+
+    // Документы с номером, канонический ключ которого равен canonical
+    const std::vector<std::uint32_t>* phoneDocs(std::uint64_t canonical) const;
+
+    // Документы с номером, в цифрах которого (канонических) есть digits
+    // в положении match; по возрастанию, без повторов
+    void findDigits(std::string_view digits, DigitMatch match, std::vector<std::uint32_t>& out) const;
+
+    // Сколько документов findDigits(digits, Infix) переберёт самое большее
+    std::size_t digitBound(std::string_view digits) const;
+
+    // Влить накопленные номера в суффиксный массив
+    void flushNumbers();
+
+    std::size_t postingCount() const { return m_postings; }
+    std::size_t gramCount() const    { return m_grams.size(); }
+
+private:
+    using Postings = std::vector<std::uint32_t>;
+
+    static void insert(Postings& list, std::uint32_t doc);
+    static void collectGrams(std::string_view text, std::uint32_t tag, std::vector<std::uint32_t>& grams);
+    void addGrams(std::uint32_t doc, std::string_view text, std::uint32_t tag);
+
+    std::string_view number(std::size_t n) const;
+    std::string_view suffix(std::uint32_t entry) const;   // entry = номер << 4 | начало
+    std::pair<std::size_t, std::size_t> suffixRange(std::string_view digits) const;
+
+    std::unordered_map<std::uint32_t, Postings> m_grams;
+    std::unordered_map<std::uint64_t, Postings> m_phones;
+
+    std::string                m_numberDigits;           // цифры всех номеров подряд
+    std::vector<std::uint32_t> m_numberStart{0};         // номеров + 1
+    std::vector<std::uint32_t> m_numberDoc;              // документ каждого номера
+    std::vector<std::uint32_t> m_suffixes;               // номер << 4 | начало, по тексту хвоста
+    std::size_t                m_sortedNumbers = 0;      // номера, чьи хвосты уже в m_suffixes
+
+    std::size_t                                 m_postings = 0;
+    std::size_t                                 m_stale = 0;
+};
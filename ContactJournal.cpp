@@ -0,0 +1,410 @@
+#include "ContactJournal.h"
+#include "ContactParser.h"
+#include <charconv>
+#include <functional>
+#include <string_view>
+#include <QByteArray>
+#include <QSaveFile>
+#include <QString>
+
+namespace {
+
+enum class RecordKind { Add, Update, Remove, Sort };
+
+struct Record
+{
+    RecordKind    kind = RecordKind::Add;
+    std::uint64_t seq = 0;
+    std::size_t   index = 0;
+    SortField     field = SortField::LastName;
+    bool          ascending = true;
+    Contact       contact;
+};
+
+std::string_view nextLine(const char*& pos, const char* end)
+{
+    const char* start = pos;
+    while (pos < end && *pos != '\n')
+        ++pos;
+    std::string_view line(start, static_cast<std::size_t>(pos - start));
+    if (pos < end)
+        ++pos;
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return line;
+}
+
+// следующее слово строки (через пробел)
+std::string_view nextToken(std::string_view& line)
+{
+    while (!line.empty() && line.front() == ' ')
+        line.remove_prefix(1);
+    std::size_t sp = line.find(' ');
+    std::string_view tok = line.substr(0, sp);
+    line.remove_prefix(sp == std::string_view::npos ? line.size() : sp);
+    return tok;
+}
+
+template <typename T>
+bool toNumber(std::string_view s, T& v)
+{
+    if (s.empty())
+        return false;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), v);
+    return res.ec == std::errc() && res.ptr == s.data() + s.size();
+}
+
+const char* sortFieldName(SortField f)
+{
+    return f == SortField::BirthDate ? "birthdate" : "lastname";
+}
+
+// Разбор одной записи журнала начиная с pos; false — запись оборвана или испорчена
+bool readRecord(const char*& pos, const char* end, Record& r)
+{
+    std::string_view header = nextLine(pos, end);
+    std::string_view kind = nextToken(header);
+
+    if (!toNumber(nextToken(header), r.seq))
+        return false;
+
+    if (kind == "ADD")
+        r.kind = RecordKind::Add;
+    else if (kind == "UPDATE")
+        r.kind = RecordKind::Update;
+    else if (kind == "REMOVE")
+        r.kind = RecordKind::Remove;
+    else if (kind == "SORT")
+        r.kind = RecordKind::Sort;
+    else
+        return false;
+
+    if (r.kind == RecordKind::Update || r.kind == RecordKind::Remove)
+    {
+        if (!toNumber(nextToken(header), r.index))
+            return false;
+    }
+
+    if (r.kind == RecordKind::Sort)
+    {
+        std::string_view field = nextToken(header);
+        std::string_view asc = nextToken(header);
+        if (field == "lastname")
+            r.field = SortField::LastName;
+        else if (field == "birthdate")
+            r.field = SortField::BirthDate;
+        else
+            return false;
+        r.ascending = (asc == "1");
+    }
+
+    if (r.kind == RecordKind::Add || r.kind == RecordKind::Update)
+    {
+        // сразу за заголовком должна идти строка CONTACT
+        const char* recordStart = pos;
+        if (nextLine(pos, end) != "CONTACT")
+            return false;
+
+        ContactParser parser(recordStart, end);
+        if (!parser.next(r.contact))
+            return false;
+        pos = parser.position();
+    }
+
+    return nextLine(pos, end) == "END";
+}
+
+// Обход корректных записей (колбэк получает и смещение начала записи);
+// возвращает смещение конца последней из них
+qint64 scanRecords(const char* data, std::size_t size,
+                   const std::function<bool(Record&, qint64)>& onRecord)
+{
+    const char* pos = data;
+    const char* end = data + size;
+    const char* validEnd = data;
+    std::uint64_t prevSeq = 0;
+
+    while (pos < end)
+    {
+        const char* start = pos;
+        Record r;
+        if (!readRecord(pos, end, r) || r.seq <= prevSeq)
+            break;
+        if (!onRecord(r, static_cast<qint64>(start - data)))
+            break;
+        prevSeq = r.seq;
+        validEnd = pos;
+    }
+
+    return static_cast<qint64>(validEnd - data);
+}
+
+} // namespace
+
+bool ContactJournal::replay(const std::string& fileName, ContactBook& book, std::uint64_t baseSeq,
+                            std::uint64_t* lastSeq, qint64* validSize)
+{
+    if (lastSeq)   *lastSeq = baseSeq;
+    if (validSize) *validSize = 0;
+
+    QFile file(QString::fromStdString(fileName));
+    if (!file.exists())
+        return true; // журнала ещё нет
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray bytes = file.readAll();
+    bool ok = true;
+
+    qint64 end = scanRecords(bytes.constData(), static_cast<std::size_t>(bytes.size()),
+                             [&](Record& r, qint64)
+    {
+        if (lastSeq && r.seq > *lastSeq)
+            *lastSeq = r.seq;
+        if (r.seq <= baseSeq)
+            return true; // уже в основном файле
+
+        switch (r.kind)
+        {
+        case RecordKind::Add:
+            book.addContact(std::move(r.contact));
+            break;
+        case RecordKind::Update:
+            ok = book.updateContact(r.index, std::move(r.contact));
+            break;
+        case RecordKind::Remove:
+            ok = book.removeContact(r.index);
+            break;
+        case RecordKind::Sort:
+            book.sortBy(r.field, r.ascending);
+            break;
+        }
+        return ok;
+    });
+
+    if (validSize)
+        *validSize = end;
+    return ok;
+}
+
+bool ContactJournal::open(const std::string& fileName, ContactBook& book, std::uint64_t baseSeq)
+{
+    close();
+
+    m_fileName = fileName;
+    m_hasPendingSort = false;
+
+    qint64 validSize = 0;
+    bool ok = replay(fileName, book, baseSeq, &m_seq, &validSize);
+
+    m_file.setFileName(QString::fromStdString(fileName));
+    if (!m_file.open(QIODevice::ReadWrite))
+        return false;
+
+    // хвост после последней целой записи не нужен
+    if (m_file.size() != validSize)
+        m_file.resize(validSize);
+    m_file.seek(validSize);
+    m_size = validSize;
+
+    return ok;
+}
+
+void ContactJournal::close()
+{
+    if (m_file.isOpen())
+        m_file.close();
+    m_size = 0;
+}
+
+bool ContactJournal::append(const std::string& record)
+{
+    if (!m_file.isOpen())
+        return false;
+
+    const qint64 n = static_cast<qint64>(record.size());
+    if (m_file.write(record.data(), n) != n || !m_file.flush())
+    {
+        // не оставляем в журнале половину записи
+        m_file.resize(m_size);
+        m_file.seek(m_size);
+        return false;
+    }
+
+    m_size += n;
+    return true;
+}
+
+void ContactJournal::setPendingSort(SortField field, bool ascending)
+{
+    m_hasPendingSort = true;
+    m_pendingField = field;
+    m_pendingAsc = ascending;
+}
+
+bool ContactJournal::flushPendingSort()
+{
+    if (!m_hasPendingSort)
+        return true;
+
+    std::string rec = "SORT " + std::to_string(m_seq + 1) + " "
+                      + sortFieldName(m_pendingField) + " "
+                      + (m_pendingAsc ? "1" : "0") + "\nEND\n";
+    if (!append(rec))
+        return false;
+
+    ++m_seq;
+    m_hasPendingSort = false;
+    return true;
+}
+
+bool ContactJournal::commitPendingSort()
+{
+    const bool ok = flushPendingSort();
+    m_hasPendingSort = false;
+    return ok;
+}
+
+bool ContactJournal::appendAdd(const Contact& c)
+{
+    if (!flushPendingSort())
+        return false;
+
+    std::string rec = "ADD " + std::to_string(m_seq + 1) + "\n";
+    ContactParser::appendRecord(rec, c);
+    rec += "END\n";
+
+    if (!append(rec))
+        return false;
+    ++m_seq;
+    return true;
+}
+
+bool ContactJournal::appendUpdate(std::size_t index, const Contact& c)
+{
+    if (!flushPendingSort())
+        return false;
+
+    std::string rec = "UPDATE " + std::to_string(m_seq + 1) + " "
+                      + std::to_string(index) + "\n";
+    ContactParser::appendRecord(rec, c);
+    rec += "END\n";
+
+    if (!append(rec))
+        return false;
+    ++m_seq;
+    return true;
+}
+
+bool ContactJournal::appendRemove(std::size_t index)
+{
+    if (!flushPendingSort())
+        return false;
+
+    std::string rec = "REMOVE " + std::to_string(m_seq + 1) + " "
+                      + std::to_string(index) + "\nEND\n";
+
+    if (!append(rec))
+        return false;
+    ++m_seq;
+    return true;
+}
+
+bool ContactJournal::dropUpTo(std::uint64_t seq)
+{
+    if (!m_file.isOpen())
+        return false;
+
+    m_file.flush();
+    m_file.seek(0);
+    const QByteArray bytes = m_file.read(m_size);
+
+    // первая запись, которой ещё нет в основном файле
+    qint64 keepFrom = -1;
+    scanRecords(bytes.constData(), static_cast<std::size_t>(bytes.size()),
+                [&](Record& r, qint64 start)
+    {
+        if (r.seq <= seq)
+            return true;
+        keepFrom = start;
+        return false;
+    });
+
+    const qint64 tailSize = keepFrom >= 0 ? m_size - keepFrom : 0;
+
+    m_file.close();
+    {
+        QSaveFile out(QString::fromStdString(m_fileName));
+        if (!out.open(QIODevice::WriteOnly))
+            return false;
+        if (tailSize > 0
+            && out.write(bytes.constData() + keepFrom, tailSize) != tailSize)
+        {
+            out.cancelWriting();
+            return false;
+        }
+        if (!out.commit())
+            return false;
+    }
+
+    if (!m_file.open(QIODevice::ReadWrite))
+        return false;
+    m_file.seek(tailSize);
+    m_size = tailSize;
+    return true;
+}
+
+bool ContactJournal::writeBase(const std::vector<Contact>& contacts,
+                               const std::string& fileName, std::uint64_t seq)
+{
+    QSaveFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const std::size_t kChunk = 1 << 20;
+    std::string buf = "JOURNAL " + std::to_string(seq) + "\n";
+    buf.reserve(kChunk + 4096);
+
+    auto flush = [&]()
+    {
+        const qint64 n = static_cast<qint64>(buf.size());
+        bool ok = file.write(buf.data(), n) == n;
+        buf.clear();
+        return ok;
+    };
+
+    for (const auto& c : contacts)
+    {
+        ContactParser::appendRecord(buf, c);
+        if (buf.size() >= kChunk && !flush())
+        {
+            file.cancelWriting();
+            return false;
+        }
+    }
+
+    if (!flush())
+    {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+std::uint64_t ContactJournal::baseSequence(const std::string& fileName)
+{
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QByteArray first = file.readLine();
+    std::string_view line(first.constData(), static_cast<std::size_t>(first.size()));
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+        line.remove_suffix(1);
+
+    if (nextToken(line) != "JOURNAL")
+        return 0;
+
+    std::uint64_t seq = 0;
+    return toNumber(nextToken(line), seq) ? seq : 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <QFile>
+#include "ContactBook.h"
+
+// Журнал изменений справочника для файлового режима.
+//
+// Каждое изменение дописывается в конец журнала одной записью
+// (O(1) операций записи вместо перезаписи всего contacts.txt):
+//   ADD <seq>            + запись CONTACT
+//   UPDATE <seq> <index> + запись CONTACT
+//   REMOVE <seq> <index>
+//   SORT <seq> <field> <asc>
+//   END
+//
+// Основной файл, записанный через writeBase, начинается со строки
+// "JOURNAL <seq>" — номера последней вошедшей в него записи журнала.
+// Старый загрузчик такую строку пропускает, как и всё до первой CONTACT.
+// При загрузке применяются только записи с номером больше этого.
+class ContactJournal
+{
+public:
+    ContactJournal() = default;
+    ContactJournal(const ContactJournal&) = delete;
+    ContactJournal& operator=(const ContactJournal&) = delete;
+
+    // Открыть журнал: применить его записи к book и подготовить к дописыванию.
+    // Оборванная последняя запись (сбой во время записи) отбрасывается.
+    bool open(const std::string& fileName, ContactBook& book, std::uint64_t baseSeq);
+    void close();
+
+    bool appendAdd(const Contact& c);
+    bool appendUpdate(std::size_t index, const Contact& c);
+    bool appendRemove(std::size_t index);
+
+    // Сортировка попадает в журнал только вместе со следующим изменением,
+    // как раньше она попадала в файл только при следующем сохранении.
+    void setPendingSort(SortField field, bool ascending);
+
+    // Перед записью основного файла из текущего справочника: отложенная
+    // сортировка в нём уже есть, её номер должен войти в номер основного файла.
+    // Иначе SORT запишется следом и при загрузке пересортирует основной файл —
+    // вместе с контактами, дописанными после сортировки (импорт), и все
+    // дальнейшие UPDATE/REMOVE по позиции попадут не в те контакты.
+    // Не записалась — сортировка всё равно забывается (она уже в основном файле)
+    bool commitPendingSort();
+
+    qint64 size() const { return m_size; }
+    std::uint64_t lastSequence() const { return m_seq; }
+
+    // Убрать из журнала записи с номером <= seq (они уже в основном файле)
+    bool dropUpTo(std::uint64_t seq);
+
+    // Применить журнал к book без открытия на запись
+    static bool replay(const std::string& fileName, ContactBook& book, std::uint64_t baseSeq,
+                       std::uint64_t* lastSeq = nullptr, qint64* validSize = nullptr);
+
+    // Записать основной файл с заголовком JOURNAL <seq> (атомарно, через временный файл)
+    static bool writeBase(const std::vector<Contact>& contacts,
+                          const std::string& fileName, std::uint64_t seq);
+
+    // Номер из заголовка основного файла (0 — заголовка нет)
+    static std::uint64_t baseSequence(const std::string& fileName);
+
+private:
+    bool append(const std::string& record);
+    bool flushPendingSort();
+
+    QFile         m_file;
+    std::string   m_fileName;
+    qint64        m_size = 0;
+    std::uint64_t m_seq  = 0;
+
+    bool      m_hasPendingSort = false;
+    SortField m_pendingField   = SortField::LastName;
+    bool      m_pendingAsc     = true;
+};
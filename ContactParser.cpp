@@ -0,0 +1,293 @@
+#include "ContactParser.h"
+#include "Parallel.h"
+#include <cstring>
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static std::string_view trimmed(std::string_view s)
+{
+    while (!s.empty() && isSpace(s.front()))
+        s.remove_prefix(1);
+    while (!s.empty() && isSpace(s.back()))
+        s.remove_suffix(1);
+    return s;
+}
+
+// как QString::toInt: вся строка (без пробелов по краям) — число, иначе 0
+static int toInt(std::string_view s)
+{
+    s = trimmed(s);
+    bool negative = false;
+    if (!s.empty() && (s.front() == '-' || s.front() == '+'))
+    {
+        negative = (s.front() == '-');
+        s.remove_prefix(1);
+    }
+    if (s.empty())
+        return 0;
+
+    long long value = 0;
+    for (char c : s)
+    {
+        if (c < '0' || c > '9')
+            return 0;
+        value = value * 10 + (c - '0');
+        if (value > 0x7FFFFFFFLL)
+            return 0;
+    }
+    return static_cast<int>(negative ? -value : value);
+}
+
+static std::string toString(std::string_view s)
+{
+    return std::string(s.data(), s.size());
+}
+
+ContactParser::ContactParser(const char* begin, const char* end)
+    : m_pos(begin)
+    , m_end(end)
+    , m_limit(end)
+{
+    // UTF-8 BOM (QTextStream тоже его пропускает)
+    if (m_end - m_pos >= 3 && std::memcmp(m_pos, "\xEF\xBB\xBF", 3) == 0)
+        m_pos += 3;
+}
+
+bool ContactParser::readLine(std::string_view& line)
+{
+    if (m_pos >= m_end)
+        return false;
+
+    const char* nl = static_cast<const char*>(
+        std::memchr(m_pos, '\n', static_cast<std::size_t>(m_end - m_pos)));
+    const char* lineEnd = nl ? nl : m_end;
+
+    line = std::string_view(m_pos, static_cast<std::size_t>(lineEnd - m_pos));
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    m_pos = nl ? nl + 1 : m_end;
+    return true;
+}
+
+bool ContactParser::next(Contact& out)
+{
+    std::string_view line;
+    const char* lineStart = m_pos;
+    while (readLine(line))
+    {
+        if (trimmed(line) != "CONTACT")
+        {
+            lineStart = m_pos;
+            continue;
+        }
+
+        if (lineStart >= m_limit)
+        {
+            m_pos = lineStart; // эта запись относится к следующему куску
+            return false;
+        }
+
+        std::string_view ln, fn, mn, addr, bday, mail;
+        if (!readLine(ln) || !readLine(fn) || !readLine(mn)
+            || !readLine(addr) || !readLine(bday) || !readLine(mail))
+        {
+            m_failed = true; // файл оборван
+            return false;
+        }
+
+        std::string_view phoneCountStr;
+        if (!readLine(phoneCountStr))
+        {
+            m_failed = true;
+            return false;
+        }
+
+        int phonesCount = toInt(phoneCountStr);
+
+        auto field = [this](std::string_view v)
+        {
+            return m_pool ? m_pool->intern(v) : SharedString(toString(v));
+        };
+
+        out = Contact();
+        out.setLastName(field(ln));
+        out.setFirstName(field(fn));
+        out.setMiddleName(field(mn));
+        out.setAddress(field(addr));
+        out.setBirthDate(Date::fromString(bday));
+        out.setEmail(toString(mail));
+
+        for (int i = 0; i < phonesCount; ++i)
+        {
+            std::string_view pLine;
+            if (!readLine(pLine)) break;
+
+            std::size_t bar = pLine.find('|');
+            if (bar == std::string_view::npos) continue;
+
+            std::string_view rest = pLine.substr(bar + 1);
+            std::string_view number = trimmed(pLine.substr(0, bar));
+            std::string_view typeStr = trimmed(rest.substr(0, rest.find('|')));
+
+            PhoneType pt = PhoneNumber::stringToType(toString(typeStr));
+            out.addPhone(PhoneNumber(number, pt));
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool ContactParser::parseAll(const char* begin, const char* end, std::vector<Contact>& out,
+                             StringPool* pool)
+{
+    ContactParser parser(begin, end);
+    parser.setPool(pool);
+    Contact c;
+    while (parser.next(c))
+        out.push_back(std::move(c));
+    return !parser.failed();
+}
+
+// Начало первой строки "CONTACT", начинающейся не раньше from
+static const char* findRecordStart(const char* begin, const char* from, const char* end)
+{
+    // встаём на начало строки
+    const char* pos = from;
+    if (pos > begin && pos[-1] != '\n')
+    {
+        pos = static_cast<const char*>(
+            std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+        if (!pos)
+            return end;
+        ++pos;
+    }
+
+    while (pos < end)
+    {
+        const char* nl = static_cast<const char*>(
+            std::memchr(pos, '\n', static_cast<std::size_t>(end - pos)));
+        const char* lineEnd = nl ? nl : end;
+        if (trimmed(std::string_view(pos, static_cast<std::size_t>(lineEnd - pos))) == "CONTACT")
+            return pos;
+        pos = nl ? nl + 1 : end;
+    }
+    return end;
+}
+
+bool ContactParser::parseParallel(const char* begin, const char* end,
+                                  std::vector<Contact>& out, unsigned threads,
+                                  bool internStrings)
+{
+    if (threads == 0)
+        threads = Parallel::workerCount();
+
+    const std::size_t size = static_cast<std::size_t>(end - begin);
+    if (threads < 2 || size < threads * std::size_t(64 * 1024))
+    {
+        StringPool pool;
+        return parseAll(begin, end, out, internStrings ? &pool : nullptr);
+    }
+
+    // Предварительные границы кусков — начала строк CONTACT.
+    // Строка CONTACT может оказаться и значением поля; такие куски
+    // ниже обнаруживаются и переразбираются последовательно.
+    std::vector<const char*> bounds{begin};
+    for (unsigned i = 1; i < threads; ++i)
+    {
+        const char* b = findRecordStart(begin, begin + size / threads * i, end);
+        if (b > bounds.back() && b < end)
+            bounds.push_back(b);
+    }
+    bounds.push_back(end);
+
+    struct Chunk
+    {
+        std::vector<Contact> contacts;
+        const char*          stop = nullptr;   // где разбор куска остановился
+        bool                 failed = false;
+    };
+
+    auto parseChunk = [&](const char* from, const char* limit, Chunk& chunk)
+    {
+        StringPool pool;
+        ContactParser parser(from, end);
+        parser.setLimit(limit);
+        if (internStrings)
+            parser.setPool(&pool);
+        Contact c;
+        while (parser.next(c))
+            chunk.contacts.push_back(std::move(c));
+        chunk.stop = parser.position();
+        chunk.failed = parser.failed();
+    };
+
+    const std::size_t count = bounds.size() - 1;
+    std::vector<Chunk> chunks(count);
+
+    Parallel::forEach(count, [&](std::size_t i)
+    {
+        parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+    }, threads);
+
+    // Кусок i верен, только если предыдущий остановился ровно на его начале
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        const char* prevStop = chunks[i - 1].stop;
+        if (prevStop == bounds[i] || chunks[i - 1].failed)
+            continue;
+
+        Chunk redo;
+        parseChunk(prevStop, bounds[i + 1], redo);
+        chunks[i] = std::move(redo);
+    }
+
+    std::size_t total = 0;
+    for (const auto& ch : chunks)
+        total += ch.contacts.size();
+    out.reserve(out.size() + total);
+
+    for (auto& ch : chunks)
+    {
+        for (auto& c : ch.contacts)
+            out.push_back(std::move(c));
+        if (ch.failed)
+            return false; // файл оборван: дальше записей нет
+    }
+
+    return true;
+}
+
+void ContactParser::appendRecord(std::string& out, const Contact& c)
+{
+    auto line = [&](const std::string& v)
+    {
+        out += v;
+        out += '\n';
+    };
+
+    out += "CONTACT\n";
+    line(c.lastName());
+    line(c.firstName());
+    line(c.middleName());
+    line(c.address());
+    char date[Date::kIsoLength];
+    out.append(date, static_cast<std::size_t>(c.birthDate().formatIso(date) - date));
+    out += '\n';
+    line(c.email());
+
+    const auto& phones = c.phones();
+    line(std::to_string(phones.size()));
+
+    for (const auto& ph : phones)
+    {
+        out += ph.number();
+        out += '|';
+        line(PhoneNumber::typeToString(ph.type()));
+    }
+}
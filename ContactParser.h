@@ -0,0 +1,53 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+#include "StringPool.h"
+
+// Разбор текстового формата contacts.txt прямо из байтового буфера
+// (например, из отображённого в память файла).
+// Строки файла не копируются: поля выделяются только в итоговые std::string.
+class ContactParser
+{
+public:
+    ContactParser(const char* begin, const char* end);
+
+    // Не начинать записи CONTACT, строка которых начинается с limit или дальше:
+    // next() вернёт false и оставит position() на этой строке.
+    void setLimit(const char* limit) { m_limit = limit; }
+
+    // Строки полей брать из пула: повторяющиеся значения не выделяются заново
+    void setPool(StringPool* pool) { m_pool = pool; }
+
+    // Читает следующую запись CONTACT.
+    // false — записей больше нет; если файл оборван, failed() == true.
+    bool next(Contact& out);
+
+    bool failed() const { return m_failed; }
+    const char* position() const { return m_pos; }
+
+    // Разобрать весь буфер; false — если файл оборван (уже прочитанное остаётся в out)
+    static bool parseAll(const char* begin, const char* end, std::vector<Contact>& out,
+                         StringPool* pool = nullptr);
+
+    // То же, но буфер делится по границам записей CONTACT на куски,
+    // которые разбираются параллельно (threads == 0 — по числу ядер).
+    // Порядок контактов в out совпадает с последовательным разбором.
+    // internStrings — у каждого куска свой пул строк (общий пул справочника
+    // потом объединяет значения разных кусков).
+    static bool parseParallel(const char* begin, const char* end,
+                              std::vector<Contact>& out, unsigned threads = 0,
+                              bool internStrings = false);
+
+    // Дописать в out запись CONTACT в том же виде, что и ContactBook::saveToFile
+    static void appendRecord(std::string& out, const Contact& c);
+
+private:
+    bool readLine(std::string_view& line);
+
+    const char* m_pos;
+    const char* m_end;
+    const char* m_limit;
+    StringPool* m_pool = nullptr;
+    bool        m_failed = false;
+};
@@ -0,0 +1,180 @@
+#include "ContactQuery.h"
+#include "SearchKey.h"
+
+namespace {
+
+struct FieldName
+{
+    const char*         name;
+    ContactQuery::Field field;
+};
+
+const FieldName kFields[] = {
+    { "last",    ContactQuery::Field::LastName },
+    { "first",   ContactQuery::Field::FirstName },
+    { "middle",  ContactQuery::Field::MiddleName },
+    { "address", ContactQuery::Field::Address },
+    { "email",   ContactQuery::Field::Email },
+    { "phone",   ContactQuery::Field::Phone },
+    { "born",    ContactQuery::Field::Born },
+    { "type",    ContactQuery::Field::Type },
+};
+
+// Следующее слово запроса (кавычки убираются, пробелы внутри них остаются);
+// key — часть до двоеточия, если слово вида «поле:значение» с известным полем
+// (регистр имени поля не важен: «Last:» — то же, что «last:»)
+bool nextToken(std::string_view text, std::size_t& pos, std::string& value, const FieldName*& key)
+{
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+        ++pos;
+    if (pos == text.size())
+        return false;
+
+    value.clear();
+    key = nullptr;
+    bool quoted = false;
+    bool seenQuote = false;
+    for (; pos < text.size() && (quoted || (text[pos] != ' ' && text[pos] != '\t')); ++pos)
+    {
+        const char ch = text[pos];
+        if (ch == '"')
+        {
+            quoted = !quoted;
+            seenQuote = true;
+            continue;
+        }
+        if (ch == ':' && !key && !seenQuote)
+        {
+            const std::string name = SearchKey::fold(value);
+            for (const FieldName& f : kFields)
+            {
+                if (name == f.name)
+                {
+                    key = &f;
+                    value.clear();
+                    break;
+                }
+            }
+            if (key)
+                continue;
+        }
+        value += ch;
+    }
+    return true;
+}
+
+// Год → первый или последний день года; иначе строго YYYY-MM-DD
+bool parseDate(std::string_view s, bool end, Date& out)
+{
+    if (s.size() == 4 && s.find_first_not_of("0123456789") == std::string_view::npos)
+    {
+        const int year = (s[0] - '0') * 1000 + (s[1] - '0') * 100 + (s[2] - '0') * 10 + (s[3] - '0');
+        out = end ? Date(year, 12, 31) : Date(year, 1, 1);
+        return year > 0;
+    }
+    return Date::parseIso(s, out) && out.isValid();
+}
+
+bool parseBorn(std::string_view s, ContactQuery::Term& term)
+{
+    const std::size_t dots = s.find("..");
+    if (dots == std::string_view::npos)
+        return parseDate(s, false, term.from) && parseDate(s, true, term.to);
+
+    const std::string_view first = s.substr(0, dots);
+    const std::string_view last = s.substr(dots + 2);
+    if (first.empty() && last.empty())
+        return false;
+
+    term.from = Date(1, 1, 1);
+    term.to = Date(Date::kMaxYear, 12, 31);
+    return (first.empty() || parseDate(first, false, term.from))
+        && (last.empty() || parseDate(last, true, term.to))
+        && term.from <= term.to;
+}
+
+bool fail(std::string* error, const std::string& message)
+{
+    if (error)
+        *error = message;
+    return false;
+}
+
+} // namespace
+
+bool ContactQuery::parse(std::string_view text, ContactQuery& out, std::string* error)
+{
+    out.m_terms.clear();
+
+    std::size_t pos = 0;
+    std::string value;
+    const FieldName* key = nullptr;
+    while (nextToken(text, pos, value, key))
+    {
+        Term term;
+        term.field = key ? key->field : Field::Any;
+        if (value.empty())
+        {
+            if (!key)
+                continue; // пустые кавычки
+            return fail(error, std::string("Пустое значение у поля ") + key->name);
+        }
+
+        switch (term.field)
+        {
+        case Field::Phone:
+            for (char ch : value)
+            {
+                if (ch >= '0' && ch <= '9')
+                    term.value += ch;
+            }
+            if (term.value.empty() || term.value.size() > PhoneNumber::kMaxDigits)
+                return fail(error, "В phone: нужны цифры номера (не больше 15): " + value);
+            break;
+
+        case Field::Born:
+            if (!parseBorn(value, term))
+                return fail(error, "born: ожидается год, дата YYYY-MM-DD или отрезок «от..до»: " + value);
+            term.value = value;
+            break;
+
+        case Field::Type:
+            term.value = SearchKey::fold(value); // «Work» — то же, что «work»
+            term.type = PhoneNumber::stringToType(term.value);
+            if (PhoneNumber::typeToString(term.type) != term.value)
+                return fail(error, "type: ожидается mobile, home, work или other: " + value);
+            if (const PhoneType* type = out.phoneType(); type && *type != term.type)
+                return fail(error, "Заданы два разных type:");
+            break;
+
+        default:
+            term.value = value;
+            break;
+        }
+        out.m_terms.push_back(std::move(term));
+    }
+    return true;
+}
+
+bool ContactQuery::isStructured(std::string_view text)
+{
+    std::size_t pos = 0;
+    std::string value;
+    const FieldName* key = nullptr;
+    while (nextToken(text, pos, value, key))
+    {
+        if (key)
+            return true;
+    }
+    return false;
+}
+
+const PhoneType* ContactQuery::phoneType() const
+{
+    for (const Term& t : m_terms)
+    {
+        if (t.field == Field::Type)
+            return &t.type;
+    }
+    return nullptr;
+}
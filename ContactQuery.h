@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Date.h"
+#include "PhoneNumber.h"
+
+// Запрос по полям: «last:Иванов phone:812 born:1980..1990 type:work email:@corp».
+//
+// Условия через пробел, выполняться должны все. «поле:значение» проверяет
+// одно поле, слово без поля ищется по всем полям, как ContactBook::find.
+// Значение с пробелами — в кавычках: address:"Невский пр.".
+//   last, first, middle, address, email — подстрока без учёта регистра
+//            (ФИО — и в транслитерации: last:Ivanov находит «Иванов»);
+//   phone  — цифры в любом месте канонического номера («812», «123-45»);
+//            вместе с type: — только в номерах этого типа;
+//   born   — год (1985), дата (1985-03-01) или отрезок через «..» с концами
+//            включительно; конец можно опустить: born:..1990;
+//   type   — есть номер этого типа: mobile, home, work, other.
+// Регистр в именах полей и в type: не важен («Last:», «type:Work»).
+// Слово с двоеточием, но с неизвестным полем («12:30»), — обычное слово.
+// Выполняет запрос ContactBook::findQuery.
+class ContactQuery
+{
+public:
+    enum class Field {
+        Any,
+        LastName,
+        FirstName,
+        MiddleName,
+        Address,
+        Email,
+        Phone,
+        Born,
+        Type
+    };
+
+    struct Term
+    {
+        Field       field = Field::Any;
+        std::string value;    // как ввели, без кавычек; Phone — только цифры
+        Date        from;     // Born
+        Date        to;
+        PhoneType   type = PhoneType::Other;   // Type
+    };
+
+    // false — ошибка в запросе, описание в error (если передан)
+    static bool parse(std::string_view text, ContactQuery& out, std::string* error = nullptr);
+
+    // Есть ли в тексте хоть одно «поле:» — строка поиска отдаёт такой текст parse()
+    static bool isStructured(std::string_view text);
+
+    const std::vector<Term>& terms() const { return m_terms; }
+    bool empty() const { return m_terms.empty(); }
+
+    // Тип из type:, если он задан, — им ограничиваются и условия phone:
+    const PhoneType* phoneType() const;
+
+private:
+    std::vector<Term> m_terms;
+};
@@ -0,0 +1,245 @@
+#include "ContactSnapshot.h"
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+
+namespace {
+
+const char kMagic[8] = { 'P', 'B', 'S', 'N', 'A', 'P', '\0', '\0' };
+const std::uint32_t kByteOrderMark = 0x01020304;
+
+// смещения, длины и счётчики в файле 32-битные
+const std::size_t kMaxField = std::numeric_limits<std::uint32_t>::max();
+
+struct Header
+{
+    char          magic[8];
+    std::uint32_t byteOrder;
+    std::uint32_t version;
+    std::uint32_t contactCount;
+    std::uint32_t phoneCount;
+    std::uint32_t poolSize;
+    std::uint32_t reserved;
+};
+
+struct StrRef
+{
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct ContactRecord
+{
+    StrRef        lastName;
+    StrRef        firstName;
+    StrRef        middleName;
+    StrRef        address;
+    StrRef        email;
+    std::uint32_t birthDate;   // год << 9 | месяц << 5 | день
+    std::uint32_t firstPhone;
+    std::uint32_t phoneCount;
+};
+
+struct PhoneRecord
+{
+    StrRef        number;
+    std::uint32_t type;
+};
+
+static_assert(sizeof(Header) == 32, "snapshot header layout");
+static_assert(sizeof(ContactRecord) == 52, "snapshot contact layout");
+static_assert(sizeof(PhoneRecord) == 12, "snapshot phone layout");
+
+// Пул строк без повторов; ключи указывают на строки исходных контактов
+class PoolBuilder
+{
+public:
+    StrRef add(std::string_view s)
+    {
+        if (s.empty())
+            return StrRef{0, 0};
+
+        auto it = m_index.find(s);
+        if (it != m_index.end())
+            return it->second;
+
+        // пул длиннее 4 ГиБ не адресуется StrRef — снимок не пишется
+        if (s.size() > kMaxField - m_pool.size())
+        {
+            m_overflow = true;
+            return StrRef{0, 0};
+        }
+
+        StrRef ref{static_cast<std::uint32_t>(m_pool.size()),
+                   static_cast<std::uint32_t>(s.size())};
+        m_pool.append(s);
+        m_index.emplace(s, ref);
+        return ref;
+    }
+
+    const std::string& data() const { return m_pool; }
+    bool overflow() const { return m_overflow; }
+
+private:
+    std::string m_pool;
+    bool        m_overflow = false;
+    std::unordered_map<std::string_view, StrRef> m_index;
+};
+
+} // namespace
+
+bool ContactSnapshot::save(const std::vector<Contact>& contacts, const std::string& fileName)
+{
+    if (contacts.size() > kMaxField)
+        return false;
+
+    PoolBuilder pool;
+    std::vector<ContactRecord> records;
+    std::vector<PhoneRecord> phones;
+    records.reserve(contacts.size());
+
+    for (const auto& c : contacts)
+    {
+        ContactRecord r{};
+        r.lastName   = pool.add(c.lastName());
+        r.firstName  = pool.add(c.firstName());
+        r.middleName = pool.add(c.middleName());
+        r.address    = pool.add(c.address());
+        r.email      = pool.add(c.email());
+        r.birthDate  = c.birthDate().packed(); // раскладка Date совпадает с форматом снимка
+        r.firstPhone = static_cast<std::uint32_t>(phones.size());
+        r.phoneCount = static_cast<std::uint32_t>(c.phones().size());
+
+        for (const auto& ph : c.phones())
+        {
+            PhoneRecord p{};
+            p.number = pool.add(ph.number());
+            p.type   = static_cast<std::uint32_t>(ph.type());
+            phones.push_back(p);
+        }
+
+        records.push_back(r);
+    }
+
+    if (pool.overflow() || phones.size() > kMaxField)
+        return false;
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.byteOrder    = kByteOrderMark;
+    h.version      = kVersion;
+    h.contactCount = static_cast<std::uint32_t>(records.size());
+    h.phoneCount   = static_cast<std::uint32_t>(phones.size());
+    h.poolSize     = static_cast<std::uint32_t>(pool.data().size());
+
+    // запись через временный файл: недописанный снимок не заменит старый
+    QSaveFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    auto put = [&](const void* p, std::size_t n)
+    {
+        return n == 0
+               || file.write(static_cast<const char*>(p), static_cast<qint64>(n))
+                      == static_cast<qint64>(n);
+    };
+
+    if (!put(&h, sizeof(h))
+        || !put(records.data(), records.size() * sizeof(ContactRecord))
+        || !put(phones.data(), phones.size() * sizeof(PhoneRecord))
+        || !put(pool.data().data(), pool.data().size()))
+    {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool ContactSnapshot::load(const std::string& fileName, std::vector<Contact>& out)
+{
+    QFile file(QString::fromStdString(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const qint64 size = file.size();
+    if (size < static_cast<qint64>(sizeof(Header)))
+        return false;
+
+    uchar* data = file.map(0, size);
+    if (data)
+        return loadFromBuffer(reinterpret_cast<const char*>(data),
+                              static_cast<std::size_t>(size), out);
+
+    const QByteArray bytes = file.readAll();
+    return loadFromBuffer(bytes.constData(), static_cast<std::size_t>(bytes.size()), out);
+}
+
+bool ContactSnapshot::loadFromBuffer(const char* data, std::size_t size, std::vector<Contact>& out)
+{
+    if (size < sizeof(Header))
+        return false;
+
+    Header h;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0
+        || h.byteOrder != kByteOrderMark
+        || h.version != kVersion)
+    {
+        return false;
+    }
+
+    const std::size_t recordsSize = std::size_t(h.contactCount) * sizeof(ContactRecord);
+    const std::size_t phonesSize  = std::size_t(h.phoneCount) * sizeof(PhoneRecord);
+    if (size != sizeof(Header) + recordsSize + phonesSize + h.poolSize)
+        return false;
+
+    const char* recordsPtr = data + sizeof(Header);
+    const char* phonesPtr  = recordsPtr + recordsSize;
+    const char* pool       = phonesPtr + phonesSize;
+
+    bool ok = true;
+    auto str = [&](const StrRef& ref)
+    {
+        if (std::size_t(ref.offset) + ref.length > h.poolSize)
+        {
+            ok = false;
+            return std::string();
+        }
+        return std::string(pool + ref.offset, ref.length);
+    };
+
+    out.clear();
+    out.reserve(h.contactCount);
+
+    for (std::uint32_t i = 0; i < h.contactCount && ok; ++i)
+    {
+        ContactRecord r;
+        std::memcpy(&r, recordsPtr + std::size_t(i) * sizeof(ContactRecord), sizeof(r));
+
+        if (std::size_t(r.firstPhone) + r.phoneCount > h.phoneCount)
+            return false;
+
+        Contact c(str(r.lastName), str(r.firstName), str(r.middleName),
+                  str(r.address), Date::fromPacked(r.birthDate), str(r.email));
+
+        for (std::uint32_t k = 0; k < r.phoneCount; ++k)
+        {
+            PhoneRecord p;
+            std::memcpy(&p, phonesPtr + std::size_t(r.firstPhone + k) * sizeof(PhoneRecord),
+                        sizeof(p));
+            PhoneType t = p.type <= static_cast<std::uint32_t>(PhoneType::Other)
+                              ? static_cast<PhoneType>(p.type)
+                              : PhoneType::Other;
+            c.addPhone(PhoneNumber(str(p.number), t));
+        }
+
+        out.push_back(std::move(c));
+    }
+
+    return ok;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Contact.h"
+
+// Двоичный снимок справочника (версионированный).
+//
+// Раскладка файла (little-endian):
+//   Header                          — сигнатура, версия, размеры секций
+//   ContactRecord[contactCount]     — таблица контактов фиксированного размера
+//   PhoneRecord[phoneCount]         — телефоны всех контактов подряд
+//   char pool[poolSize]             — пул строк UTF-8 без повторов
+//
+// Строки в записях — пары (смещение, длина) в пуле, даты упакованы в uint32.
+// Загрузка — одно чтение файла без разбора полей.
+// Смещения и счётчики 32-битные: справочник, которому нужен пул строк больше
+// 4 ГиБ, save() не пишет и возвращает false.
+// Текстовый contacts.txt остаётся форматом обмена, снимок — только кэш для быстрого старта.
+class ContactSnapshot
+{
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    static bool save(const std::vector<Contact>& contacts, const std::string& fileName);
+    static bool load(const std::string& fileName, std::vector<Contact>& out);
+
+    // Разбор снимка, уже прочитанного в память
+    static bool loadFromBuffer(const char* data, std::size_t size, std::vector<Contact>& out);
+};
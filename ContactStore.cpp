@@ -0,0 +1,172 @@
+#include "ContactStore.h"
+#include <algorithm>
+
+void ContactStore::assign(const std::vector<Contact>& contacts)
+{
+    clear();
+
+    std::size_t bytes[Phone] = {};
+    std::size_t phones = 0;
+    std::size_t phoneBytes = 0;
+    for (const auto& c : contacts)
+    {
+        bytes[LastName]   += c.lastName().size();
+        bytes[FirstName]  += c.firstName().size();
+        bytes[MiddleName] += c.middleName().size();
+        bytes[Address]    += c.address().size();
+        bytes[Email]      += c.email().size();
+        phones += c.phones().size();
+        for (const auto& ph : c.phones())
+            phoneBytes += ph.number().size();
+    }
+
+    for (int col = 0; col < Phone; ++col)
+    {
+        m_text[col].chars.reserve(bytes[col]);
+        m_text[col].offsets.reserve(contacts.size() + 1);
+    }
+    m_birthDates.reserve(contacts.size());
+    m_phones.chars.reserve(phoneBytes);
+    m_phones.offsets.reserve(phones + 1);
+    m_phoneKeys.reserve(phones);
+    m_phoneFirst.reserve(contacts.size() + 1);
+
+    for (const auto& c : contacts)
+        append(c);
+}
+
+void ContactStore::append(const Contact& c)
+{
+    m_text[LastName].push(c.lastName());
+    m_text[FirstName].push(c.firstName());
+    m_text[MiddleName].push(c.middleName());
+    m_text[Address].push(c.address());
+    m_text[Email].push(c.email());
+    m_birthDates.push_back(c.birthDate());
+
+    for (const auto& ph : c.phones())
+    {
+        m_phones.push(ph.number());
+        m_phoneKeys.push_back(ph.canonical());
+    }
+    m_phoneFirst.push_back(m_phones.count());
+}
+
+void ContactStore::clear()
+{
+    for (auto& col : m_text)
+        col.clear();
+    m_birthDates.clear();
+    m_phones.clear();
+    m_phoneKeys.clear();
+    m_phoneFirst.assign(1, 0);
+}
+
+std::string_view ContactStore::text(Column column, std::size_t index) const
+{
+    return m_text[column].at(index);
+}
+
+std::size_t ContactStore::phoneCount(std::size_t index) const
+{
+    return m_phoneFirst[index + 1] - m_phoneFirst[index];
+}
+
+std::string_view ContactStore::phone(std::size_t index, std::size_t k) const
+{
+    return m_phones.at(m_phoneFirst[index] + k);
+}
+
+std::uint64_t ContactStore::phoneKey(std::size_t index, std::size_t k) const
+{
+    return m_phoneKeys[m_phoneFirst[index] + k];
+}
+
+void ContactStore::markPhone(std::uint64_t canonical, std::vector<char>& hits) const
+{
+    if (canonical == 0)
+        return;
+
+    std::size_t contact = 0;
+    for (std::size_t k = 0; k < m_phoneKeys.size(); ++k)
+    {
+        if (m_phoneKeys[k] != canonical)
+            continue;
+
+        while (m_phoneFirst[contact + 1] <= k)
+            ++contact;
+        hits[contact] = 1;
+    }
+}
+
+std::vector<std::size_t> ContactStore::sortedOrder(SortField field, bool ascending) const
+{
+    std::vector<std::size_t> order(size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    switch (field)
+    {
+    case SortField::LastName:
+    {
+        const TextColumn& col = m_text[LastName];
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+        {
+            return ascending ? col.at(a) < col.at(b) : col.at(b) < col.at(a);
+        });
+        break;
+    }
+
+    case SortField::BirthDate:
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b)
+        {
+            return ascending ? m_birthDates[a] < m_birthDates[b]
+                             : m_birthDates[b] < m_birthDates[a];
+        });
+        break;
+    }
+
+    return order;
+}
+
+void ContactStore::permute(const std::vector<std::size_t>& order)
+{
+    auto permuteText = [&](TextColumn& col, const std::vector<std::size_t>& records)
+    {
+        TextColumn out;
+        out.chars.reserve(col.chars.size());
+        out.offsets.reserve(records.size() + 1);
+        for (std::size_t i : records)
+            out.push(col.at(i));
+        col = std::move(out);
+    };
+
+    for (auto& col : m_text)
+        permuteText(col, order);
+
+    std::vector<Date> dates;
+    dates.reserve(m_birthDates.size());
+    for (std::size_t i : order)
+        dates.push_back(m_birthDates[i]);
+    m_birthDates = std::move(dates);
+
+    // номера переставляются вместе со своими контактами
+    std::vector<std::size_t> numbers;
+    std::vector<std::size_t> first{0};
+    numbers.reserve(m_phones.count());
+    first.reserve(m_phoneFirst.size());
+    for (std::size_t i : order)
+    {
+        for (std::size_t k = m_phoneFirst[i]; k < m_phoneFirst[i + 1]; ++k)
+            numbers.push_back(k);
+        first.push_back(numbers.size());
+    }
+    permuteText(m_phones, numbers);
+
+    std::vector<std::uint64_t> keys;
+    keys.reserve(numbers.size());
+    for (std::size_t k : numbers)
+        keys.push_back(m_phoneKeys[k]);
+    m_phoneKeys = std::move(keys);
+    m_phoneFirst = std::move(first);
+}
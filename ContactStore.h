@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+
+enum class SortField {
+    LastName,
+    BirthDate
+};
+
+// Столбцовое представление справочника (structure of arrays).
+//
+// На каждое поле — свой непрерывный столбец: текст всех контактов подряд
+// в одной строке и смещения начала записей. Дата рождения — столбец
+// Date (4 байта: год, месяц и день упакованы в одно число, сравниваются как числа).
+// Телефоны — один столбец номеров всех контактов, столбец их канонических
+// ключей (PhoneNumber::canonical) и смещения первого номера каждого контакта.
+// Поиск номера и сортировка читают только память своего столбца,
+// а не объекты Contact целиком.
+class ContactStore
+{
+public:
+    enum Column {
+        LastName,
+        FirstName,
+        MiddleName,
+        Address,
+        Email,
+        Phone,
+        ColumnCount
+    };
+
+    void assign(const std::vector<Contact>& contacts);
+    void append(const Contact& c);
+    void clear();
+
+    std::size_t size() const { return m_birthDates.size(); }
+
+    std::string_view text(Column column, std::size_t index) const;   // кроме Phone
+    Date birthDate(std::size_t index) const { return m_birthDates[index]; }
+
+    std::size_t phoneCount(std::size_t index) const;
+    std::string_view phone(std::size_t index, std::size_t k) const;
+    std::uint64_t phoneKey(std::size_t index, std::size_t k) const;
+
+    // Отметить в hits (размер size()) контакты с номером, канонически равным canonical
+    void markPhone(std::uint64_t canonical, std::vector<char>& hits) const;
+
+    // Порядок индексов после устойчивой сортировки
+    std::vector<std::size_t> sortedOrder(SortField field, bool ascending) const;
+
+    // Переставить записи: новая i-я — бывшая order[i]
+    void permute(const std::vector<std::size_t>& order);
+
+private:
+    struct TextColumn
+    {
+        std::string              chars;
+        std::vector<std::size_t> offsets{0};   // записей + 1
+
+        std::size_t count() const { return offsets.size() - 1; }
+        std::string_view at(std::size_t i) const
+        {
+            return std::string_view(chars).substr(offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        void push(std::string_view s)
+        {
+            chars.append(s.data(), s.size());
+            offsets.push_back(chars.size());
+        }
+        void clear()
+        {
+            chars.clear();
+            offsets.assign(1, 0);
+        }
+    };
+
+    TextColumn                 m_text[Phone];      // LastName..Email
+    std::vector<Date>          m_birthDates;
+    TextColumn                 m_phones;           // номера всех контактов подряд
+    std::vector<std::uint64_t> m_phoneKeys;        // канонический ключ каждого номера
+    std::vector<std::size_t>   m_phoneFirst{0};    // контактов + 1: первый номер контакта
+};
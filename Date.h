@@ -1,38 +1,170 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <iomanip>
-#include <sstream>
+#include <string_view>
 
-struct Date
+// Дата: год, месяц и день упакованы в одно 32-битное число
+// (год << 9 | месяц << 5 | день), поэтому даты сравниваются одним
+// сравнением целых. Разбор и вывод YYYY-MM-DD — без потоков и выделений памяти.
+class Date
 {
-    int year{0};
-    int month{0};
-    int day{0};
+public:
+    static constexpr std::size_t kIsoLength = 10;   // YYYY-MM-DD
+    static constexpr int kMaxYear = 9999;
 
-    bool isValid() const
+    constexpr Date() = default;
+
+    // Поле вне диапазона (год 0..9999, месяц 0..15, день 0..31) → пустая дата
+    constexpr Date(int year, int month, int day)
+        : m_packed(pack(year, month, day))
+    {
+    }
+
+    constexpr int year() const  { return static_cast<int>(m_packed >> 9); }
+    constexpr int month() const { return static_cast<int>((m_packed >> 5) & 0x0F); }
+    constexpr int day() const   { return static_cast<int>(m_packed & 0x1F); }
+
+    // Упакованное значение — для снимков и столбцов
+    constexpr std::uint32_t packed() const { return m_packed; }
+    static constexpr Date fromPacked(std::uint32_t v)
+    {
+        Date d;
+        d.m_packed = v;
+        return d;
+    }
+
+    constexpr bool isValid() const
     {
-        if (year <= 0 || month < 1 || month > 12 || day < 1 || day > 31)
+        if (year() <= 0 || month() < 1 || month() > 12 || day() < 1 || day() > 31)
             return false;
         // очень упрощённая проверка, без високосных лет
         return true;
     }
 
+    // Записать ровно kIsoLength символов (без завершающего нуля); конец записанного
+    constexpr char* formatIso(char* out) const
+    {
+        int y = year();
+        for (int i = 3; i >= 0; --i, y /= 10)
+            out[i] = static_cast<char>('0' + y % 10);
+        out[4] = '-';
+        out[5] = static_cast<char>('0' + month() / 10);
+        out[6] = static_cast<char>('0' + month() % 10);
+        out[7] = '-';
+        out[8] = static_cast<char>('0' + day() / 10);
+        out[9] = static_cast<char>('0' + day() % 10);
+        return out + kIsoLength;
+    }
+
     std::string toString() const
     {
-        std::ostringstream os;
-        os << std::setfill('0')
-           << std::setw(4) << year << "-"
-           << std::setw(2) << month << "-"
-           << std::setw(2) << day;
-        return os.str();
+        char buf[kIsoLength] = {};
+        formatIso(buf);
+        return std::string(buf, kIsoLength); // короче SSO — без кучи
     }
 
-    static Date fromString(const std::string& s)
+    // Строго YYYY-MM-DD; false — строка не в этом виде
+    static constexpr bool parseIso(std::string_view s, Date& out)
+    {
+        if (s.size() != kIsoLength || s[4] != '-' || s[7] != '-')
+            return false;
+
+        int v[3] = {};
+        const std::size_t from[3] = { 0, 5, 8 };
+        const std::size_t to[3]   = { 4, 7, 10 };
+        for (int f = 0; f < 3; ++f)
+        {
+            for (std::size_t i = from[f]; i < to[f]; ++i)
+            {
+                if (s[i] < '0' || s[i] > '9')
+                    return false;
+                v[f] = v[f] * 10 + (s[i] - '0');
+            }
+        }
+
+        out = Date(v[0], v[1], v[2]);
+        return true;
+    }
+
+    // Обычно YYYY-MM-DD; иначе — три числа через любые разделители
+    // («2000-1-5»), как раньше читал istringstream. Не разобралось — пустая дата.
+    static Date fromString(std::string_view s)
     {
         Date d;
-        char dash1 = 0, dash2 = 0;
-        std::istringstream is(s);
-        is >> d.year >> dash1 >> d.month >> dash2 >> d.day;
-        return d;
+        if (parseIso(s, d))
+            return d;
+
+        int v[3] = {};
+        std::size_t pos = 0;
+        for (int f = 0; f < 3; ++f)
+        {
+            while (pos < s.size() && s[pos] == ' ')
+                ++pos;
+            if (f != 0)
+            {
+                if (pos >= s.size())
+                    break;
+                ++pos; // разделитель
+            }
+
+            bool negative = false;
+            if (pos < s.size() && (s[pos] == '-' || s[pos] == '+'))
+                negative = s[pos++] == '-';
+
+            const std::size_t start = pos;
+            while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && v[f] < 100000)
+                v[f] = v[f] * 10 + (s[pos++] - '0');
+            if (pos == start)
+                break;
+            if (negative)
+                v[f] = -v[f];
+        }
+
+        return Date(v[0], v[1], v[2]);
+    }
+
+    // Столбцы целиком: count дат подряд по kIsoLength символов (без разделителей)
+    static void formatIso(const Date* dates, std::size_t count, char* out)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out = dates[i].formatIso(out);
     }
+
+    // count строк → count дат; не в виде YYYY-MM-DD — через fromString.
+    // Возвращает, сколько строк прошло быстрый разбор.
+    static std::size_t parseIso(const std::string_view* texts, std::size_t count, Date* out)
+    {
+        std::size_t fast = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (parseIso(texts[i], out[i]))
+                ++fast;
+            else
+                out[i] = fromString(texts[i]);
+        }
+        return fast;
+    }
+
+    friend constexpr bool operator==(Date a, Date b) { return a.m_packed == b.m_packed; }
+    friend constexpr bool operator!=(Date a, Date b) { return a.m_packed != b.m_packed; }
+    friend constexpr bool operator<(Date a, Date b)  { return a.m_packed <  b.m_packed; }
+    friend constexpr bool operator>(Date a, Date b)  { return a.m_packed >  b.m_packed; }
+    friend constexpr bool operator<=(Date a, Date b) { return a.m_packed <= b.m_packed; }
+    friend constexpr bool operator>=(Date a, Date b) { return a.m_packed >= b.m_packed; }
+
+private:
+    static constexpr std::uint32_t pack(int year, int month, int day)
+    {
+        if (year < 0 || year > kMaxYear || month < 0 || month > 15 || day < 0 || day > 31)
+            return 0;
+        return (static_cast<std::uint32_t>(year) << 9)
+             | (static_cast<std::uint32_t>(month) << 5)
+             | static_cast<std::uint32_t>(day);
+    }
+
+    std::uint32_t m_packed = 0;
 };
+
+static_assert(Date(2024, 2, 29) < Date(2024, 3, 1), "packed order must follow calendar order");
+static_assert(Date(1999, 12, 31).year() == 1999 && Date(1999, 12, 31).day() == 31, "");
@@ -0,0 +1,64 @@
+#include "IncrementalSearch.h"
+
+const std::vector<std::size_t>& IncrementalSearch::search(const std::string& query)
+{
+    return *searchImpl(query, nullptr);
+}
+
+const std::vector<std::size_t>* IncrementalSearch::search(const std::string& query, const std::atomic<bool>& cancel)
+{
+    return searchImpl(query, &cancel);
+}
+
+bool IncrementalSearch::needsFullSearch(const std::string& query) const
+{
+    if (m_revision != m_book.revision())
+        return true;
+
+    // верхний из запросов, которые новый продолжает
+    auto top = m_levels.rbegin();
+    while (top != m_levels.rend() && query.compare(0, top->query.size(), top->query) != 0)
+        ++top;
+    return top == m_levels.rend() || (top->query.empty() && !query.empty());
+}
+
+const std::vector<std::size_t>* IncrementalSearch::searchImpl(const std::string& query,
+                                                              const std::atomic<bool>* cancel)
+{
+    if (m_revision != m_book.revision())
+    {
+        m_levels.clear();
+        m_revision = m_book.revision();
+    }
+
+    // снять запросы, которые новый не продолжает (стёртые буквы, другой запрос)
+    while (!m_levels.empty() && query.compare(0, m_levels.back().query.size(), m_levels.back().query) != 0)
+        m_levels.pop_back();
+
+    if (!m_levels.empty() && m_levels.back().query == query)
+    {
+        m_lastStep = Step::Cached;
+        return &m_levels.back().found;
+    }
+
+    Level level;
+    level.query = query;
+    if (m_levels.empty() || m_levels.back().query.empty())
+    {
+        if (!cancel)
+            level.found = m_book.find(query);
+        else if (!m_book.find(query, level.found, *cancel))
+            return nullptr;
+        m_lastStep = Step::Full;
+    }
+    else
+    {
+        level.found = m_book.refine(m_levels.back().found, m_levels.back().query, query);
+        m_lastStep = Step::Refined;
+    }
+
+    if (m_levels.size() == kMaxLevels)
+        m_levels.erase(m_levels.begin()); // самый короткий запрос
+    m_levels.push_back(std::move(level));
+    return &m_levels.back().found;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ContactBook.h"
+
+// Поиск по мере ввода: результаты ContactBook::find для строки, которую
+// набирают по букве.
+//
+// Хранит стопку последних запросов с их результатами, каждый следующий
+// продолжает предыдущий. Запрос продолжает верхний — результат получается
+// сужением верхнего (ContactBook::refine), время пропорционально его размеру,
+// а не размеру справочника. Стёрли букву — результат берётся из стопки
+// без поиска. Справочник изменился (ContactBook::revision) — стопка сбрасывается.
+class IncrementalSearch
+{
+public:
+    static constexpr std::size_t kMaxLevels = 32;
+
+    enum class Step {
+        Full,      // поиск по всему справочнику
+        Refined,   // сужение предыдущего результата
+        Cached     // результат из стопки
+    };
+
+    explicit IncrementalSearch(const ContactBook& book) : m_book(book) {}
+
+    // Позиции в contacts() по возрастанию, как у ContactBook::find(query)
+    const std::vector<std::size_t>& search(const std::string& query);
+
+    // То же с отменой (см. ContactBook::find с cancel): nullptr — поиск
+    // отменён, его результат в стопку не попадает. Можно вызывать из другого
+    // потока, пока справочник и этот объект больше никто не трогает
+    const std::vector<std::size_t>* search(const std::string& query, const std::atomic<bool>& cancel);
+
+    // Будет ли search(query) искать по всему справочнику,
+    // а не сужать прежний результат или брать его из стопки
+    bool needsFullSearch(const std::string& query) const;
+
+    Step lastStep() const { return m_lastStep; }
+    std::size_t depth() const { return m_levels.size(); }
+    void clear() { m_levels.clear(); }
+
+private:
+    const std::vector<std::size_t>* searchImpl(const std::string& query, const std::atomic<bool>* cancel);
+
+    struct Level
+    {
+        std::string              query;
+        std::vector<std::size_t> found;
+    };
+
+    const ContactBook&  m_book;
+    std::vector<Level>  m_levels;
+    std::uint64_t       m_revision = 0;
+    Step                m_lastStep = Step::Full;
+};
@@ -0,0 +1,155 @@
+#include "LzCodec.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const std::size_t kMinMatch   = 4;
+const std::size_t kMaxOffset  = 65535;
+const int         kHashBits   = 14;
+// совпадения не ищутся в последних байтах — там остаются литералы
+const std::size_t kTailLiterals = 8;
+
+std::uint32_t read32(const char* p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint32_t hash32(std::uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+void putLength(std::string& out, std::size_t len)
+{
+    while (len >= 255)
+    {
+        out += static_cast<char>(255);
+        len -= 255;
+    }
+    out += static_cast<char>(len);
+}
+
+void putSequence(std::string& out, const char* literals, std::size_t litLen,
+                 std::size_t offset, std::size_t matchLen)
+{
+    const std::size_t m = matchLen ? matchLen - kMinMatch : 0;
+    const unsigned char token = static_cast<unsigned char>(
+        ((litLen < 15 ? litLen : 15) << 4) | (m < 15 ? m : 15));
+    out += static_cast<char>(token);
+
+    if (litLen >= 15)
+        putLength(out, litLen - 15);
+    out.append(literals, litLen);
+
+    if (matchLen == 0)
+        return;
+
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>((offset >> 8) & 0xFF);
+    if (m >= 15)
+        putLength(out, m - 15);
+}
+
+bool readLength(const unsigned char*& p, const unsigned char* end, std::size_t& len)
+{
+    unsigned char b;
+    do
+    {
+        if (p >= end)
+            return false;
+        b = *p++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+void LzCodec::compress(const char* src, std::size_t size, std::string& out)
+{
+    std::vector<std::uint32_t> table(std::size_t(1) << kHashBits, 0);
+
+    std::size_t anchor = 0;
+    std::size_t ip = 0;
+
+    if (size > kTailLiterals + kMinMatch)
+    {
+        const std::size_t limit = size - kTailLiterals;
+
+        while (ip < limit)
+        {
+            const std::uint32_t seq = read32(src + ip);
+            const std::uint32_t h = hash32(seq);
+            // в таблице хранится позиция + 1, 0 — пусто
+            const std::size_t ref = table[h];
+            table[h] = static_cast<std::uint32_t>(ip + 1);
+
+            if (ref == 0 || ip - (ref - 1) > kMaxOffset || read32(src + ref - 1) != seq)
+            {
+                ++ip;
+                continue;
+            }
+
+            const std::size_t from = ref - 1;
+            std::size_t len = kMinMatch;
+            while (ip + len < limit && src[from + len] == src[ip + len])
+                ++len;
+
+            putSequence(out, src + anchor, ip - anchor, ip - from, len);
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    putSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+bool LzCodec::decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize)
+{
+    const unsigned char* p   = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = p + srcSize;
+    std::size_t op = 0;
+
+    while (p < end)
+    {
+        const unsigned char token = *p++;
+
+        std::size_t litLen = token >> 4;
+        if (litLen == 15 && !readLength(p, end, litLen))
+            return false;
+        if (litLen > static_cast<std::size_t>(end - p) || litLen > dstSize - op)
+            return false;
+
+        std::memcpy(dst + op, p, litLen);
+        p  += litLen;
+        op += litLen;
+
+        if (p == end)
+            break; // последняя последовательность — только литералы
+
+        if (end - p < 2)
+            return false;
+        const std::size_t offset = std::size_t(p[0]) | (std::size_t(p[1]) << 8);
+        p += 2;
+
+        std::size_t matchLen = token & 0x0F;
+        if (matchLen == 15 && !readLength(p, end, matchLen))
+            return false;
+        matchLen += kMinMatch;
+
+        if (offset == 0 || offset > op || matchLen > dstSize - op)
+            return false;
+
+        // побайтно: источник и приёмник могут перекрываться
+        const char* from = dst + op - offset;
+        for (std::size_t i = 0; i < matchLen; ++i)
+            dst[op + i] = from[i];
+        op += matchLen;
+    }
+
+    return op == dstSize;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Простой LZ77-кодек в духе LZ4 (без внешних зависимостей).
+//
+// Поток — последовательность «литералы + совпадение»:
+//   токен (старшие 4 бита — длина литералов, младшие — длина совпадения - 4),
+//   продолжение длины литералов байтами 255..., литералы,
+//   смещение совпадения (2 байта, little-endian), продолжение длины совпадения.
+// Последняя последовательность содержит только литералы.
+class LzCodec
+{
+public:
+    // Дописать сжатые данные в out
+    static void compress(const char* src, std::size_t size, std::string& out);
+
+    // Распаковать ровно dstSize байт; false — повреждённые данные
+    static bool decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize);
+};
@@ -0,0 +1,146 @@
+#include "NameTrie.h"
+#include <algorithm>
+#include "SearchKey.h"
+
+namespace {
+
+// Разбор UTF-8; неправильные байты — каждый сам по себе
+std::u32string decode(std::string_view text)
+{
+    std::u32string out;
+    out.reserve(text.size());
+    for (std::size_t i = 0; i < text.size();)
+    {
+        const unsigned char b = static_cast<unsigned char>(text[i]);
+        const std::size_t len = b < 0x80 ? 1 : (b >> 5) == 0x06 ? 2 : (b >> 4) == 0x0E ? 3 : (b >> 3) == 0x1E ? 4 : 0;
+        if (len <= 1 || i + len > text.size())
+        {
+            out += char32_t(b);
+            ++i;
+            continue;
+        }
+
+        char32_t ch = b & (0xFF >> (len + 1));
+        for (std::size_t k = 1; k < len; ++k)
+            ch = ch << 6 | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        out += ch;
+        i += len;
+    }
+    return out;
+}
+
+bool isSeparator(char32_t ch)
+{
+    return ch == ' ' || ch == '-' || ch == '\t' || ch == ',' || ch == '.';
+}
+
+} // namespace
+
+std::vector<std::u32string> NameTrie::words(std::string_view text)
+{
+    const std::u32string decoded = decode(SearchKey::fold(text));
+
+    std::vector<std::u32string> out;
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= decoded.size(); ++i)
+    {
+        if (i == decoded.size() || isSeparator(decoded[i]))
+        {
+            if (i > start)
+                out.push_back(decoded.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    return out;
+}
+
+void NameTrie::add(std::uint32_t doc, const Contact& c)
+{
+    const std::string* fields[] = { &c.lastName(), &c.firstName(), &c.middleName() };
+    for (std::uint32_t field = LastName; field <= MiddleName; ++field)
+    {
+        for (const auto& word : words(*fields[field]))
+            addWord(word, doc << 2 | field);
+    }
+}
+
+void NameTrie::addWord(std::u32string_view word, std::uint32_t posting)
+{
+    std::uint32_t node = 0;
+    for (char32_t ch : word)
+    {
+        std::uint32_t child = m_nodes[node].firstChild;
+        while (child != kNone && m_nodes[child].ch != ch)
+            child = m_nodes[child].next;
+
+        if (child == kNone)
+        {
+            child = static_cast<std::uint32_t>(m_nodes.size());
+            Node added;
+            added.ch = ch;
+            added.next = m_nodes[node].firstChild;
+            m_nodes.push_back(added);
+            m_nodes[node].firstChild = child;
+        }
+        node = child;
+    }
+
+    if (m_nodes[node].word == kNone)
+    {
+        m_nodes[node].word = static_cast<std::uint32_t>(m_postings.size());
+        m_postings.emplace_back();
+    }
+
+    // одно и то же слово дважды в поле («Анна-Анна») — одно вхождение
+    std::vector<std::uint32_t>& list = m_postings[m_nodes[node].word];
+    if (list.empty() || list.back() != posting)
+        list.push_back(posting);
+}
+
+void NameTrie::clear()
+{
+    m_nodes.assign(1, Node());
+    m_postings.clear();
+}
+
+void NameTrie::search(std::u32string_view word, unsigned maxDistance, std::vector<WordMatch>& out) const
+{
+    out.clear();
+
+    // строка таблицы для корня: расстояние от пустого префикса до начала запроса
+    std::vector<unsigned> rows(word.size() + 1);
+    for (std::size_t j = 0; j <= word.size(); ++j)
+        rows[j] = static_cast<unsigned>(j);
+
+    walk(0, word, maxDistance, rows, 0, out);
+}
+
+void NameTrie::walk(std::uint32_t node, std::u32string_view query, unsigned maxDistance,
+                    std::vector<unsigned>& rows, std::size_t depth, std::vector<WordMatch>& out) const
+{
+    // строки всех узлов пути лежат в rows подряд, по n + 1 значений
+    const std::size_t n = query.size();
+    if (rows.size() < (depth + 2) * (n + 1))
+        rows.resize((depth + 2) * (n + 1));
+    const std::size_t prev = depth * (n + 1);
+    const std::size_t cur = prev + n + 1;
+
+    for (std::uint32_t child = m_nodes[node].firstChild; child != kNone; child = m_nodes[child].next)
+    {
+        const char32_t ch = m_nodes[child].ch;
+        rows[cur] = rows[prev] + 1;
+        unsigned best = rows[cur];
+        for (std::size_t j = 1; j <= n; ++j)
+        {
+            rows[cur + j] = std::min({ rows[prev + j] + 1,                          // лишний символ в слове
+                                       rows[cur + j - 1] + 1,                       // пропущенный символ
+                                       rows[prev + j - 1] + (query[j - 1] != ch) }); // замена
+            best = std::min(best, rows[cur + j]);
+        }
+
+        if (m_nodes[child].word != kNone && rows[cur + n] <= maxDistance)
+            out.push_back({ m_nodes[child].word, rows[cur + n] });
+        if (best <= maxDistance)
+            walk(child, query, maxDistance, rows, depth + 1, out);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Contact.h"
+
+// Словарь слов из ФИО контактов для поиска с опечатками.
+//
+// Слова (фамилия, имя, отчество в сложенном регистре, см. SearchKey;
+// двойные — «Анна-Мария» — по частям) хранятся в префиксном дереве по
+// символам Unicode, у каждого слова — список документов, где оно встречается.
+// search() обходит дерево, для каждого узла считая строку таблицы
+// расстояния Левенштейна до запроса; ветка, где все значения строки больше
+// допустимого, дальше не просматривается. Различных слов в справочнике на
+// порядки меньше, чем контактов, и почти все ветки отсекаются у корня, —
+// поэтому время поиска почти не зависит от размера справочника.
+//
+// Документ — номер слота контакта (SlotHandle::slot), как в ContactIndex.
+// Слова удалённых и изменённых контактов из словаря не удаляются —
+// после таких изменений ContactBook строит его заново.
+class NameTrie
+{
+public:
+    // Поле, из которого слово; меньше — важнее при ранжировании
+    enum Field : std::uint8_t {
+        LastName,
+        FirstName,
+        MiddleName
+    };
+
+    struct WordMatch
+    {
+        std::uint32_t word;
+        unsigned      distance;
+    };
+
+    void add(std::uint32_t doc, const Contact& c);
+    void clear();
+
+    // Слова запроса в той же форме, что слова словаря (сложенный регистр)
+    static std::vector<std::u32string> words(std::string_view text);
+
+    // Слова словаря на расстоянии не больше maxDistance от word
+    void search(std::u32string_view word, unsigned maxDistance, std::vector<WordMatch>& out) const;
+
+    // Где встречается слово: документ << 2 | Field
+    const std::vector<std::uint32_t>& postings(std::uint32_t word) const { return m_postings[word]; }
+
+    std::size_t wordCount() const { return m_postings.size(); }
+    std::size_t nodeCount() const { return m_nodes.size(); }
+
+private:
+    static constexpr std::uint32_t kNone = static_cast<std::uint32_t>(-1);
+
+    struct Node
+    {
+        char32_t      ch = 0;
+        std::uint32_t firstChild = kNone;
+        std::uint32_t next = kNone;    // следующий брат
+        std::uint32_t word = kNone;    // слово, которое кончается здесь
+    };
+
+    void addWord(std::u32string_view word, std::uint32_t posting);
+    void walk(std::uint32_t node, std::u32string_view query, unsigned maxDistance,
+              std::vector<unsigned>& rows, std::size_t depth, std::vector<WordMatch>& out) const;
+
+    std::vector<Node>                       m_nodes{Node()};   // [0] — корень
+    std::vector<std::vector<std::uint32_t>> m_postings;        // по номеру слова
+};
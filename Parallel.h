@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Простейший пул потоков на время одного вызова.
+// Задачи 0..count-1 разбираются потоками по очереди через атомарный счётчик.
+class Parallel
+{
+public:
+    static unsigned workerCount()
+    {
+        unsigned n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    template <typename Fn>
+    static void forEach(std::size_t count, Fn fn, unsigned threads = 0)
+    {
+        if (threads == 0)
+            threads = workerCount();
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+
+        if (threads <= 1)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                fn(i);
+            return;
+        }
+
+        std::atomic<std::size_t> next{0};
+        auto worker = [&]()
+        {
+            for (std::size_t i = next++; i < count; i = next++)
+                fn(i);
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t)
+            pool.emplace_back(worker);
+
+        worker(); // текущий поток тоже работает
+
+        for (auto& th : pool)
+            th.join();
+    }
+};
@@ -1,8 +1,142 @@
 #include "PhoneNumber.h"
+#include <cstring>
 
-PhoneNumber::PhoneNumber(std::string number, PhoneType type)
-    : m_number(std::move(number)), m_type(type)
+PhoneNumber::PhoneNumber(std::string_view number, PhoneType type)
+    : m_key(static_cast<std::uint64_t>(type))
 {
+    setNumber(number);
+}
+
+PhoneNumber::PhoneNumber(const PhoneNumber& other)
+{
+    setNumber(other.number());
+    m_key = other.m_key;
+}
+
+PhoneNumber::PhoneNumber(PhoneNumber&& other) noexcept
+    : m_key(other.m_key), m_length(other.m_length)
+{
+    // длинный номер: копируется указатель, буфер переходит к нам
+    std::memcpy(m_chars, other.m_chars, isInline() ? m_length : sizeof(char*));
+    other.m_length = 0;
+}
+
+PhoneNumber& PhoneNumber::operator=(const PhoneNumber& other)
+{
+    if (this != &other)
+    {
+        setNumber(other.number());
+        m_key = other.m_key;
+    }
+    return *this;
+}
+
+PhoneNumber& PhoneNumber::operator=(PhoneNumber&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_key = other.m_key;
+        m_length = other.m_length;
+        std::memcpy(m_chars, other.m_chars, isInline() ? m_length : sizeof(char*));
+        other.m_length = 0;
+    }
+    return *this;
+}
+
+PhoneNumber::~PhoneNumber()
+{
+    release();
+}
+
+char* PhoneNumber::heap() const
+{
+    char* p = nullptr;
+    std::memcpy(&p, m_chars, sizeof(p));
+    return p;
+}
+
+void PhoneNumber::setHeap(char* p)
+{
+    std::memcpy(m_chars, &p, sizeof(p));
+}
+
+void PhoneNumber::release()
+{
+    if (!isInline())
+        delete[] heap();
+    m_length = 0;
+}
+
+void PhoneNumber::setNumber(std::string_view n)
+{
+    const std::uint64_t canonical = canonicalize(n);
+
+    // n может указывать на наш же номер — копируем до release()
+    if (n.size() > kInlineSize)
+    {
+        char* buf = new char[n.size()];
+        std::memcpy(buf, n.data(), n.size());
+        release();
+        setHeap(buf);
+    }
+    else
+    {
+        char buf[kInlineSize];
+        std::memcpy(buf, n.data(), n.size());
+        release();
+        std::memcpy(m_chars, buf, n.size());
+    }
+    m_length = static_cast<std::uint32_t>(n.size());
+    m_key = (canonical << kTypeBits) | (m_key & kTypeMask);
+}
+
+bool PhoneNumber::sameNumber(const PhoneNumber& other) const
+{
+    if (canonical() != 0 || other.canonical() != 0)
+        return canonical() == other.canonical();
+    return number() == other.number();
+}
+
+std::uint64_t PhoneNumber::canonicalize(std::string_view text)
+{
+    // Раскладка: цифры числом (до 10^15 < 2^50) << 4 | количество цифр,
+    // количество нужно, чтобы «0123» и «123» различались.
+    std::uint64_t value = 0;
+    std::size_t digits = 0;
+    bool plus = false;
+    for (char ch : text)
+    {
+        if (ch >= '0' && ch <= '9')
+        {
+            if (++digits > kMaxDigits)
+                return 0;
+            value = value * 10 + static_cast<std::uint64_t>(ch - '0');
+        }
+        else if (ch == '+' && digits == 0)
+        {
+            plus = true;
+        }
+    }
+
+    if (digits == 0)
+        return 0;
+
+    // 8XXXXXXXXXX — тот же номер, что +7XXXXXXXXXX
+    const std::uint64_t kTrunk8 = 80000000000ULL;
+    if (!plus && digits == 11 && value / 10000000000ULL == 8)
+        value = value - kTrunk8 + 70000000000ULL;
+
+    return (value << 4) | digits;
+}
+
+std::size_t PhoneNumber::digits(std::uint64_t canonical, char* out)
+{
+    const std::size_t count = static_cast<std::size_t>(canonical & 0x0F);
+    std::uint64_t value = canonical >> 4;
+    for (std::size_t i = count; i-- > 0; value /= 10)
+        out[i] = static_cast<char>('0' + value % 10);
+    return count;
 }
 
 std::string PhoneNumber::typeToString(PhoneType t)
@@ -1,5 +1,9 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 
 enum class PhoneType {
     Mobile,
@@ -8,22 +12,95 @@ enum class PhoneType {
     Other
 };
 
+// Номер телефона: текст, как его ввели, и канонический ключ.
+//
+// Ключ — 64-битное число: цифры номера (не больше 15, как в E.164),
+// их количество и тип телефона. Российские 8XXXXXXXXXX приводятся к 7XXXXXXXXXX,
+// поэтому «+78121234567» и «8(812)123-45-67» дают одинаковый ключ.
+// Сравнение, хеш и сортировка телефонов идут по ключу, без разбора строк.
 class PhoneNumber
 {
 public:
+    // Номер до kInlineSize байт хранится внутри объекта, без кучи
+    // («+7 (999) 123-45-67» — 18 байт); длиннее — в куче.
+    static constexpr std::size_t kInlineSize = 20;
+    static constexpr std::size_t kMaxDigits = 15;
+
     PhoneNumber() = default;
-    PhoneNumber(std::string number, PhoneType type);
+    PhoneNumber(std::string_view number, PhoneType type);
+
+    PhoneNumber(const PhoneNumber& other);
+    PhoneNumber(PhoneNumber&& other) noexcept;
+    PhoneNumber& operator=(const PhoneNumber& other);
+    PhoneNumber& operator=(PhoneNumber&& other) noexcept;
+    ~PhoneNumber();
+
+    std::string_view number() const { return std::string_view(chars(), m_length); }
+    PhoneType type() const { return static_cast<PhoneType>(m_key & kTypeMask); }
+
+    void setNumber(std::string_view n);
+    void setType(PhoneType t) { m_key = (m_key & ~kTypeMask) | static_cast<std::uint64_t>(t); }
 
-    const std::string& number() const { return m_number; }
-    PhoneType type() const { return m_type; }
+    // Канонический номер + тип; разные записи одного номера дают один ключ
+    std::uint64_t key() const { return m_key; }
 
-    void setNumber(const std::string& n) { m_number = n; }
-    void setType(PhoneType t) { m_type = t; }
+    // Только номер, без типа; 0 — в тексте нет цифр или их больше 15
+    std::uint64_t canonical() const { return m_key >> kTypeBits; }
+
+    // Один и тот же номер (тип не важен)
+    bool sameNumber(const PhoneNumber& other) const;
+
+    // Канонический номер из текста (как canonical()), без создания PhoneNumber
+    static std::uint64_t canonicalize(std::string_view text);
+
+    // Цифры канонического номера (до kMaxDigits) в out; возвращает их количество
+    static std::size_t digits(std::uint64_t canonical, char* out);
 
     static std::string typeToString(PhoneType t);
     static PhoneType stringToType(const std::string& s);
 
+    // Равны — один номер одного типа
+    friend bool operator==(const PhoneNumber& a, const PhoneNumber& b)
+    {
+        return a.m_key == b.m_key && (a.canonical() != 0 || a.number() == b.number());
+    }
+    friend bool operator!=(const PhoneNumber& a, const PhoneNumber& b) { return !(a == b); }
+
+    // Порядок по ключу; номера без канонической формы — по тексту
+    friend bool operator<(const PhoneNumber& a, const PhoneNumber& b)
+    {
+        if (a.m_key != b.m_key)
+            return a.m_key < b.m_key;
+        return a.canonical() == 0 && a.number() < b.number();
+    }
+
 private:
-    std::string m_number;
-    PhoneType   m_type{PhoneType::Mobile};
+    static constexpr int           kTypeBits = 2;
+    static constexpr std::uint64_t kTypeMask = (1u << kTypeBits) - 1;
+
+    bool isInline() const { return m_length <= kInlineSize; }
+    const char* chars() const { return isInline() ? m_chars : heap(); }
+
+    // Длинный номер: в начале m_chars лежит указатель на буфер в куче
+    char* heap() const;
+    void setHeap(char* p);
+    void release();
+
+    std::uint64_t m_key = 0;         // canonical << kTypeBits | тип
+    std::uint32_t m_length = 0;
+    char          m_chars[kInlineSize];
+};
+
+// Хеш по ключу — для unordered-контейнеров телефонов
+namespace std {
+template <>
+struct hash<PhoneNumber>
+{
+    std::size_t operator()(const PhoneNumber& p) const noexcept
+    {
+        if (p.canonical() != 0)
+            return std::hash<std::uint64_t>()(p.key());
+        return std::hash<std::string_view>()(p.number()) ^ static_cast<std::size_t>(p.type());
+    }
 };
+} // namespace std
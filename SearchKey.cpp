@@ -0,0 +1,100 @@
+#include "SearchKey.h"
+#include "Translit.h"
+
+void SearchKey::appendFolded(std::string& out, std::string_view text)
+{
+    const std::size_t start = out.size();
+    out.append(text.data(), text.size());
+
+    // все замены — два байта на два байта, поэтому прямо на месте
+    char* p = &out[0] + start;
+    char* const end = p + text.size();
+    for (; p < end; ++p)
+    {
+        const unsigned char b = static_cast<unsigned char>(*p);
+        if (b < 0x80)
+        {
+            if (b >= 'A' && b <= 'Z')
+                *p = static_cast<char>(b + ('a' - 'A'));
+            continue;
+        }
+        if (p + 1 == end)
+            break;
+
+        const unsigned char next = static_cast<unsigned char>(p[1]);
+        if (b == 0xD0)
+        {
+            if (next >= 0x80 && next <= 0x8F)          // Ѐ..Џ, в т.ч. Ё → ѐ..џ
+            {
+                p[0] = static_cast<char>(0xD1);
+                p[1] = static_cast<char>(next + 0x10);
+            }
+            else if (next >= 0x90 && next <= 0x9F)     // А..П → а..п
+            {
+                p[1] = static_cast<char>(next + 0x20);
+            }
+            else if (next >= 0xA0 && next <= 0xAF)     // Р..Я → р..я
+            {
+                p[0] = static_cast<char>(0xD1);
+                p[1] = static_cast<char>(next - 0x20);
+            }
+            ++p;
+        }
+        else if (b == 0xC3)
+        {
+            if (next >= 0x80 && next <= 0x9E && next != 0x97)   // À..Þ, кроме ×
+                p[1] = static_cast<char>(next + 0x20);
+            ++p;
+        }
+    }
+}
+
+std::string SearchKey::fold(std::string_view text)
+{
+    std::string out;
+    appendFolded(out, text);
+    return out;
+}
+
+std::string SearchKey::build(const Contact& c)
+{
+    std::string key;
+    key.reserve(c.lastName().size() + c.firstName().size() + c.middleName().size()
+                + c.address().size() + c.email().size() + 16 * (c.phones().size() + 1));
+
+    appendFolded(key, c.lastName());
+    for (const std::string* field : { &c.firstName(), &c.middleName(), &c.address(), &c.email() })
+    {
+        key += ' ';
+        appendFolded(key, *field);
+    }
+    for (const auto& ph : c.phones())
+    {
+        key += ' ';
+        appendFolded(key, ph.number());
+    }
+    return key;
+}
+
+TranslitKey SearchKey::buildTranslit(const Contact& c)
+{
+    TranslitKey key;
+    Translit::append(key.text, c.lastName());
+    key.lastEnd = static_cast<std::uint32_t>(key.text.size());
+    key.text += ' ';
+    Translit::append(key.text, c.firstName());
+    key.firstEnd = static_cast<std::uint32_t>(key.text.size());
+    key.text += ' ';
+    Translit::append(key.text, c.middleName());
+
+    key.script = Translit::script(c.lastName());
+    for (const std::string* field : { &c.firstName(), &c.middleName() })
+    {
+        if (key.script == Translit::Script::Cyrillic)
+            break;
+        const Translit::Script s = Translit::script(*field);
+        if (s != Translit::Script::None)
+            key.script = s;
+    }
+    return key;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Contact.h"
+#include "Translit.h"
+
+// Ключ транслитерации ФИО контакта (см. Translit): фамилия, имя и отчество
+// через пробел — «Иванов» и «Ivanov» в нём одинаковы. script — письмо ФИО
+// (кириллица, если она есть хоть в одном из трёх полей): по ключу контакт
+// находят запросы другого письма
+struct TranslitKey
+{
+    std::string      text;
+    std::uint32_t    lastEnd = 0;    // конец фамилии в text
+    std::uint32_t    firstEnd = 0;   // конец имени
+    Translit::Script script = Translit::Script::None;
+
+    std::string_view lastName() const   { return std::string_view(text).substr(0, lastEnd); }
+    std::string_view firstName() const  { return std::string_view(text).substr(lastEnd + 1, firstEnd - lastEnd - 1); }
+    std::string_view middleName() const { return std::string_view(text).substr(firstEnd + 1); }
+};
+
+// Ключ поиска контакта: все его поля одной строкой (через пробел, как их
+// видит фильтр таблицы) в «сложенном» регистре. Поиск без учёта регистра —
+// это поиск сложенного образца в сложенном ключе.
+//
+// Складываются латиница (A–Z, À–Þ) и кириллица, включая Ё → ё и Ѐ–Џ → ѐ–џ.
+// Длина текста в байтах UTF-8 при этом не меняется.
+class SearchKey
+{
+public:
+    static void appendFolded(std::string& out, std::string_view text);
+    static std::string fold(std::string_view text);
+
+    static std::string build(const Contact& c);
+    static TranslitKey buildTranslit(const Contact& c);
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <utility>
+
+// Неизменяемая строка с общим владением (8 байт на поле вместо 32 у std::string).
+//
+// Копия — только счётчик ссылок, текст не копируется, поэтому одинаковые значения
+// (после StringPool::intern) хранятся в памяти один раз. Счётчик атомарный:
+// копии контактов можно отдавать фоновым потокам записи.
+// Пустая строка памяти не занимает.
+class SharedString
+{
+public:
+    SharedString() = default;
+
+    explicit SharedString(std::string s)
+        : m_rep(s.empty() ? nullptr : new Rep{{1}, std::move(s)})
+    {
+    }
+
+    SharedString(const SharedString& other) noexcept
+        : m_rep(other.m_rep)
+    {
+        if (m_rep)
+            m_rep->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SharedString(SharedString&& other) noexcept
+        : m_rep(other.m_rep)
+    {
+        other.m_rep = nullptr;
+    }
+
+    SharedString& operator=(SharedString other) noexcept
+    {
+        std::swap(m_rep, other.m_rep);
+        return *this;
+    }
+
+    ~SharedString()
+    {
+        if (m_rep && m_rep->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete m_rep;
+    }
+
+    const std::string& str() const
+    {
+        static const std::string empty;
+        return m_rep ? m_rep->str : empty;
+    }
+
+    bool empty() const { return m_rep == nullptr; }
+
+    // Одно и то же значение в памяти (а не просто равный текст)
+    const void* id() const { return m_rep; }
+
+    std::size_t useCount() const
+    {
+        return m_rep ? m_rep->refs.load(std::memory_order_relaxed) : 0;
+    }
+
+    // Сколько памяти занимает само значение (без учёта ссылок на него)
+    static std::size_t valueBytes(const std::string& s);
+
+private:
+    struct Rep
+    {
+        std::atomic<std::size_t> refs;
+        std::string              str;
+    };
+
+    Rep* m_rep = nullptr;
+};
+
+inline std::size_t SharedString::valueBytes(const std::string& s)
+{
+    // короткие строки std::string держит внутри себя (SSO), длинные — в куче
+    const std::size_t heap = s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+    return sizeof(Rep) + heap;
+}
@@ -0,0 +1,261 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Ссылка на элемент SlotMap, которая не «съезжает» при удалении и сортировке.
+// Поколение отличает удалённый элемент от нового в том же слоте:
+// устаревший handle просто перестаёт находиться.
+struct SlotHandle
+{
+    std::uint32_t slot = 0;
+    std::uint32_t generation = 0;   // 0 — пустой handle
+
+    bool isNull() const { return generation == 0; }
+
+    friend bool operator==(SlotHandle a, SlotHandle b)
+    {
+        return a.slot == b.slot && a.generation == b.generation;
+    }
+    friend bool operator!=(SlotHandle a, SlotHandle b) { return !(a == b); }
+};
+
+namespace std {
+template <>
+struct hash<SlotHandle>
+{
+    std::size_t operator()(SlotHandle h) const noexcept
+    {
+        return std::hash<std::uint64_t>()((std::uint64_t(h.generation) << 32) | h.slot);
+    }
+};
+} // namespace std
+
+// Слот-таблица: элементы лежат плотно в векторе (обход — как по std::vector),
+// доступ по SlotHandle через таблицу слотов.
+//
+// Вставка и поиск по handle — O(1). Удаление сохраняет порядок, как
+// std::vector::erase: следующие элементы сдвигаются, их записи в таблице
+// слотов исправляются; handle остаются действительными. Удаление пачкой —
+// eraseDeferred() для каждого и один compact() — сдвигает массив один раз.
+template <typename T>
+class SlotMap
+{
+public:
+    using Handle = SlotHandle;
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    Handle insert(T value)
+    {
+        return emplace(std::move(value));
+    }
+
+    // Элемент создаётся сразу на своём месте в плотном массиве
+    template <typename... Args>
+    Handle emplace(Args&&... args)
+    {
+        m_values.emplace_back(std::forward<Args>(args)...);
+        const std::uint32_t dense = static_cast<std::uint32_t>(m_values.size() - 1);
+
+        std::uint32_t slot;
+        if (m_freeHead != kNoSlot)
+        {
+            slot = m_freeHead;
+            m_freeHead = m_slots[slot].dense; // у свободного слота — следующий свободный
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(m_slots.size());
+            m_slots.push_back(Slot{});
+        }
+
+        m_slots[slot].dense = dense;
+        m_denseToSlot.push_back(slot);
+        return Handle{slot, m_slots[slot].generation};
+    }
+
+    bool erase(Handle h)
+    {
+        if (!eraseDeferred(h))
+            return false;
+        compact();
+        return true;
+    }
+
+    // Удалить без сдвига: handle сразу устаревает, а элемент остаётся дырой
+    // в плотном массиве до compact(). Пока дыры есть, позиции (indexOf,
+    // handleAt, values()) не действительны — только доступ по handle.
+    bool eraseDeferred(Handle h)
+    {
+        const std::size_t dense = indexOf(h);
+        if (dense == npos)
+            return false;
+
+        m_denseToSlot[dense] = kNoSlot;
+        m_firstHole = std::min(m_firstHole, dense);
+        freeSlot(h.slot);
+        return true;
+    }
+
+    // Убрать дыры, сохранив порядок остальных элементов
+    void compact()
+    {
+        if (m_firstHole == npos)
+            return;
+
+        std::size_t out = m_firstHole;
+        for (std::size_t i = m_firstHole; i < m_values.size(); ++i)
+        {
+            const std::uint32_t slot = m_denseToSlot[i];
+            if (slot == kNoSlot)
+                continue;
+            if (out != i)
+            {
+                m_values[out] = std::move(m_values[i]);
+                m_denseToSlot[out] = slot;
+            }
+            m_slots[slot].dense = static_cast<std::uint32_t>(out);
+            ++out;
+        }
+        m_values.erase(m_values.begin() + static_cast<std::ptrdiff_t>(out), m_values.end());
+        m_denseToSlot.resize(out);
+        m_firstHole = npos;
+    }
+
+    bool contains(Handle h) const { return indexOf(h) != npos; }
+
+    T* get(Handle h)
+    {
+        const std::size_t dense = indexOf(h);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    const T* get(Handle h) const
+    {
+        const std::size_t dense = indexOf(h);
+        return dense == npos ? nullptr : &m_values[dense];
+    }
+
+    // Позиция элемента в плотном векторе; npos — handle устарел
+    std::size_t indexOf(Handle h) const
+    {
+        if (h.slot >= m_slots.size() || h.isNull() || m_slots[h.slot].generation != h.generation)
+            return npos;
+        return m_slots[h.slot].dense;
+    }
+
+    // То же по одному номеру слота (без поколения); npos — слот свободен
+    std::size_t indexOfSlot(std::uint32_t slot) const
+    {
+        if (slot >= m_slots.size())
+            return npos;
+        // у занятого слота позиция указывает обратно на него
+        const std::uint32_t dense = m_slots[slot].dense;
+        return dense < m_denseToSlot.size() && m_denseToSlot[dense] == slot ? dense : npos;
+    }
+
+    Handle handleAt(std::size_t index) const
+    {
+        const std::uint32_t slot = m_denseToSlot[index];
+        return Handle{slot, m_slots[slot].generation};
+    }
+
+    std::size_t size() const { return m_values.size(); }
+    bool empty() const       { return m_values.empty(); }
+
+    void reserve(std::size_t n)
+    {
+        m_values.reserve(n);
+        m_denseToSlot.reserve(n);
+        m_slots.reserve(n);
+    }
+
+    // Плотный массив элементов: обход, запись в файл, поиск по столбцам
+    const std::vector<T>& values() const { return m_values; }
+
+    // Заменить всё содержимое (загрузка файла); прежние handle устаревают
+    void assign(std::vector<T>&& values)
+    {
+        clear();
+        m_values = std::move(values);
+        m_denseToSlot.reserve(m_values.size());
+        for (std::size_t i = 0; i < m_values.size(); ++i)
+        {
+            std::uint32_t slot;
+            if (m_freeHead != kNoSlot)
+            {
+                slot = m_freeHead;
+                m_freeHead = m_slots[slot].dense;
+            }
+            else
+            {
+                slot = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.push_back(Slot{});
+            }
+            m_slots[slot].dense = static_cast<std::uint32_t>(i);
+            m_denseToSlot.push_back(slot);
+        }
+    }
+
+    void clear()
+    {
+        for (std::uint32_t slot : m_denseToSlot)
+        {
+            if (slot != kNoSlot)
+                freeSlot(slot);
+        }
+        m_values.clear();
+        m_denseToSlot.clear();
+        m_firstHole = npos;
+    }
+
+    // Переставить элементы: новый i-й — бывший order[i]. Handle не меняются.
+    void permute(const std::vector<std::size_t>& order)
+    {
+        std::vector<T> values;
+        std::vector<std::uint32_t> denseToSlot;
+        values.reserve(order.size());
+        denseToSlot.reserve(order.size());
+        for (std::size_t i : order)
+        {
+            values.push_back(std::move(m_values[i]));
+            denseToSlot.push_back(m_denseToSlot[i]);
+        }
+        m_values = std::move(values);
+        m_denseToSlot = std::move(denseToSlot);
+
+        for (std::size_t i = 0; i < m_denseToSlot.size(); ++i)
+            m_slots[m_denseToSlot[i]].dense = static_cast<std::uint32_t>(i);
+    }
+
+    // Прямой доступ для изменения элемента на месте (handle не меняется)
+    T& operator[](std::size_t index)             { return m_values[index]; }
+    const T& operator[](std::size_t index) const { return m_values[index]; }
+
+private:
+    static constexpr std::uint32_t kNoSlot = 0xFFFFFFFFu;
+
+    struct Slot
+    {
+        std::uint32_t dense = 0;        // позиция в m_values; у свободного — следующий свободный
+        std::uint32_t generation = 1;
+    };
+
+    void freeSlot(std::uint32_t slot)
+    {
+        // новое поколение: старые handle на этот слот больше не находятся
+        if (++m_slots[slot].generation == 0)
+            m_slots[slot].generation = 1;
+        m_slots[slot].dense = m_freeHead;
+        m_freeHead = slot;
+    }
+
+    std::vector<T>             m_values;
+    std::vector<std::uint32_t> m_denseToSlot;
+    std::vector<Slot>          m_slots;
+    std::uint32_t              m_freeHead = kNoSlot;
+    std::size_t                m_firstHole = npos;   // первая дыра после eraseDeferred
+};
@@ -0,0 +1,188 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Вектор с местом под N элементов внутри самого объекта.
+//
+// Пока элементов не больше N, куча не используется; дальше — как std::vector
+// (ёмкость удваивается, элементы переносятся). Для коротких списков вроде
+// телефонов контакта: у большинства их один–три.
+template <typename T, std::size_t N>
+class SmallVector
+{
+public:
+    using value_type     = T;
+    using iterator       = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+
+    SmallVector(const SmallVector& other)
+    {
+        reserve(other.m_size);
+        for (const T& v : other)
+            new (m_data + m_size++) T(v);
+    }
+
+    SmallVector(SmallVector&& other) noexcept
+    {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(const SmallVector& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other.m_size);
+            for (const T& v : other)
+                new (m_data + m_size++) T(v);
+        }
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            releaseHeap();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector()
+    {
+        clear();
+        releaseHeap();
+    }
+
+    std::size_t size() const     { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool empty() const           { return m_size == 0; }
+
+    // Элементы лежат внутри объекта, а не в куче
+    bool isInline() const { return m_data == inlineData(); }
+
+    T*       data()       { return m_data; }
+    const T* data() const { return m_data; }
+
+    iterator       begin()       { return m_data; }
+    iterator       end()         { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const   { return m_data + m_size; }
+
+    T&       operator[](std::size_t i)       { return m_data[i]; }
+    const T& operator[](std::size_t i) const { return m_data[i]; }
+
+    T&       front()       { return m_data[0]; }
+    const T& front() const { return m_data[0]; }
+    T&       back()        { return m_data[m_size - 1]; }
+    const T& back() const  { return m_data[m_size - 1]; }
+
+    void push_back(const T& v)
+    {
+        if (m_size == m_capacity)
+        {
+            T copy(v); // v может лежать в этом же векторе
+            grow(m_size + 1);
+            new (m_data + m_size++) T(std::move(copy));
+            return;
+        }
+        new (m_data + m_size++) T(v);
+    }
+
+    void push_back(T&& v)
+    {
+        emplace_back(std::move(v));
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (m_size == m_capacity)
+            grow(m_size + 1);
+        T* p = new (m_data + m_size) T(std::forward<Args>(args)...);
+        ++m_size;
+        return *p;
+    }
+
+    void pop_back()
+    {
+        m_data[--m_size].~T();
+    }
+
+    void clear()
+    {
+        for (std::size_t i = 0; i < m_size; ++i)
+            m_data[i].~T();
+        m_size = 0;
+    }
+
+    void reserve(std::size_t n)
+    {
+        if (n > m_capacity)
+            grow(n);
+    }
+
+private:
+    T*       inlineData()       { return reinterpret_cast<T*>(m_inline); }
+    const T* inlineData() const { return reinterpret_cast<const T*>(m_inline); }
+
+    void grow(std::size_t minCapacity)
+    {
+        std::size_t capacity = m_capacity * 2;
+        if (capacity < minCapacity)
+            capacity = minCapacity;
+
+        T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            new (data + i) T(std::move(m_data[i]));
+            m_data[i].~T();
+        }
+
+        releaseHeap();
+        m_data = data;
+        m_capacity = static_cast<std::uint32_t>(capacity);
+    }
+
+    void releaseHeap()
+    {
+        if (!isInline())
+            ::operator delete(m_data);
+        m_data = inlineData();
+        m_capacity = N;
+    }
+
+    // Этот вектор пуст и без кучи
+    void takeFrom(SmallVector& other) noexcept
+    {
+        if (other.isInline())
+        {
+            for (std::size_t i = 0; i < other.m_size; ++i)
+            {
+                new (m_data + i) T(std::move(other.m_data[i]));
+                other.m_data[i].~T();
+            }
+        }
+        else
+        {
+            // чужой буфер в куче просто забираем
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            other.m_data = other.inlineData();
+            other.m_capacity = N;
+        }
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+
+    T*            m_data = inlineData();
+    std::uint32_t m_size = 0;
+    std::uint32_t m_capacity = N;
+    alignas(T) unsigned char m_inline[N * sizeof(T)];
+};
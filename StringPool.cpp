@@ -0,0 +1,40 @@
+#include "StringPool.h"
+
+SharedString StringPool::intern(const SharedString& s)
+{
+    if (s.empty())
+        return s;
+
+    const std::string& text = s.str();
+    auto it = m_values.find(std::string_view(text));
+    if (it != m_values.end())
+        return it->second;
+
+    m_values.emplace(std::string_view(text), s);
+    return s;
+}
+
+SharedString StringPool::intern(std::string_view s)
+{
+    if (s.empty())
+        return SharedString();
+
+    auto it = m_values.find(s);
+    if (it != m_values.end())
+        return it->second;
+
+    SharedString value{std::string(s)};
+    m_values.emplace(std::string_view(value.str()), value);
+    return value;
+}
+
+void StringPool::purge()
+{
+    for (auto it = m_values.begin(); it != m_values.end();)
+    {
+        if (it->second.useCount() == 1)
+            it = m_values.erase(it);
+        else
+            ++it;
+    }
+}
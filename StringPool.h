@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "SharedString.h"
+
+// Пул неизменяемых строк: одинаковый текст → одно значение SharedString.
+//
+// Пул держит по ссылке на каждое значение; когда контакты, использовавшие
+// значение, удалены, purge() его освобождает.
+// Не потокобезопасен — принадлежит справочнику (ContactBook).
+class StringPool
+{
+public:
+    // Значение из пула; если такого текста ещё нет — s становится значением пула
+    // (без копирования)
+    SharedString intern(const SharedString& s);
+    SharedString intern(std::string_view s);
+
+    // Освободить значения, на которые ссылается только пул
+    void purge();
+    void clear() { m_values.clear(); }
+
+    std::size_t size() const { return m_values.size(); }
+
+private:
+    // ключ указывает на текст значения — он не меняется, пока значение в пуле
+    std::unordered_map<std::string_view, SharedString> m_values;
+};
@@ -0,0 +1,171 @@
+#include "SubstringScan.h"
+#include <algorithm>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PHONEBOOK_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using FindFn = std::size_t (*)(std::string_view text, std::size_t from, std::string_view needle);
+
+std::size_t findScalar(std::string_view text, std::size_t from, std::string_view needle)
+{
+    return text.find(needle, from);
+}
+
+#ifdef PHONEBOOK_SIMD_X86
+
+// Совпали первый и последний байт в позиции i + bit — проверить середину
+inline bool middleMatches(const char* at, std::string_view needle)
+{
+    return needle.size() <= 2 || std::memcmp(at + 1, needle.data() + 1, needle.size() - 2) == 0;
+}
+
+__attribute__((target("sse2")))
+std::size_t findSse2(std::string_view text, std::size_t from, std::string_view needle)
+{
+    const std::size_t n = needle.size();
+    const char* s = text.data();
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+
+    std::size_t i = from;
+    for (; i + n - 1 + 16 <= text.size(); i += 16)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + n - 1));
+        unsigned mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask != 0)
+        {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (middleMatches(s + i + bit, needle))
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return text.find(needle, i); // хвост короче регистра
+}
+
+__attribute__((target("avx2")))
+std::size_t findAvx2(std::string_view text, std::size_t from, std::string_view needle)
+{
+    const std::size_t n = needle.size();
+    const char* s = text.data();
+    const __m256i first = _mm256_set1_epi8(needle.front());
+    const __m256i last = _mm256_set1_epi8(needle.back());
+
+    std::size_t i = from;
+    for (; i + n - 1 + 32 <= text.size(); i += 32)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i + n - 1));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask != 0)
+        {
+            const unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (middleMatches(s + i + bit, needle))
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return text.find(needle, i);
+}
+
+#endif // PHONEBOOK_SIMD_X86
+
+FindFn kernelFn(SubstringScan::Kernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef PHONEBOOK_SIMD_X86
+    case SubstringScan::Kernel::Sse2: return findSse2;
+    case SubstringScan::Kernel::Avx2: return findAvx2;
+#endif
+    default:                          return findScalar;
+    }
+}
+
+} // namespace
+
+bool SubstringScan::supported(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Scalar:
+        return true;
+#ifdef PHONEBOOK_SIMD_X86
+    case Kernel::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case Kernel::Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+SubstringScan::Kernel SubstringScan::best()
+{
+    static const Kernel kernel = supported(Kernel::Avx2) ? Kernel::Avx2
+                               : supported(Kernel::Sse2) ? Kernel::Sse2
+                                                         : Kernel::Scalar;
+    return kernel;
+}
+
+const char* SubstringScan::name(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Kernel::Scalar: return "scalar";
+    case Kernel::Sse2:   return "sse2";
+    case Kernel::Avx2:   return "avx2";
+    }
+    return "";
+}
+
+void SubstringScan::scan(std::string_view text, const std::vector<std::size_t>& offsets,
+                         std::string_view needle, std::vector<std::size_t>& out, Kernel kernel)
+{
+    out.clear();
+    if (offsets.size() >= 2)
+        scan(text, offsets, 0, offsets.size() - 1, needle, out, kernel);
+}
+
+void SubstringScan::scan(std::string_view text, const std::vector<std::size_t>& offsets,
+                         std::size_t first, std::size_t last,
+                         std::string_view needle, std::vector<std::size_t>& out, Kernel kernel)
+{
+    if (needle.empty() || first >= last)
+        return;
+
+    // один байт — memchr библиотеки уже векторный
+    const FindFn find = needle.size() == 1 ? findScalar : kernelFn(supported(kernel) ? kernel : best());
+    const std::size_t begin = offsets[first];
+    text = text.substr(0, offsets[last]); // совпадение не выходит за последнюю запись
+
+    std::size_t record = first;
+    std::size_t pos = find(text, begin, needle);
+    while (pos != std::string_view::npos)
+    {
+        // последняя запись, начинающаяся не позже pos (пустые записи пропускаются)
+        record = static_cast<std::size_t>(
+            std::upper_bound(offsets.begin() + static_cast<long>(record), offsets.begin() + static_cast<long>(last), pos)
+            - offsets.begin()) - 1;
+
+        const std::size_t recordEnd = offsets[record + 1];
+        if (pos + needle.size() <= recordEnd)
+        {
+            out.push_back(record);
+            pos = find(text, recordEnd, needle); // остальные вхождения в записи не нужны
+        }
+        else
+        {
+            pos = find(text, pos + 1, needle);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Поиск подстроки сразу во многих записях, лежащих подряд в одном буфере
+// (например, ключи поиска всех контактов).
+//
+// Ядро SSE2/AVX2 сравнивает первый и последний байт образца сразу в 16/32
+// позициях текста и проверяет целиком только позиции, где совпали оба, —
+// так кириллица, где почти каждый второй байт 0xD0/0xD1, не даёт лишних
+// проверок. Ядро выбирается при запуске по возможностям процессора;
+// на других архитектурах и компиляторах остаётся обычный string_view::find.
+// Результат у всех ядер одинаковый.
+class SubstringScan
+{
+public:
+    enum class Kernel {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    // Лучшее ядро для этого процессора
+    static Kernel best();
+    static bool supported(Kernel kernel);
+    static const char* name(Kernel kernel);
+
+    // Текст i-й записи — text[offsets[i], offsets[i + 1]), offsets — записей + 1.
+    // В out — номера записей, где есть needle, по возрастанию.
+    // Совпадение, захватившее конец одной записи и начало следующей, не считается.
+    // Неподдерживаемое ядро заменяется на best().
+    static void scan(std::string_view text, const std::vector<std::size_t>& offsets,
+                     std::string_view needle, std::vector<std::size_t>& out,
+                     Kernel kernel = best());
+
+    // То же только для записей first..last-1 (часть буфера для одного потока);
+    // найденные дописываются в out, номера записей — общие
+    static void scan(std::string_view text, const std::vector<std::size_t>& offsets,
+                     std::size_t first, std::size_t last,
+                     std::string_view needle, std::vector<std::size_t>& out,
+                     Kernel kernel = best());
+};
@@ -0,0 +1,140 @@
+#include "Translit.h"
+#include "SearchKey.h"
+
+namespace {
+
+// а..я (U+0430..U+044F) по порядку
+const char* const kCyrillic[32] = {
+    "a", "b", "v", "g", "d", "e", "zh", "z", "i", "y", "k", "l", "m", "n", "o", "p",
+    "r", "s", "t", "u", "f", "kh", "ts", "ch", "sh", "shch", "", "y", "", "e", "yu", "ya"
+};
+
+// Прочие буквы кириллицы после складывания регистра
+struct Letter
+{
+    char32_t    ch;
+    const char* latin;
+};
+
+const Letter kOtherLetters[] = {
+    { U'ё', "e" }, { U'є', "e" }, { U'і', "i" }, { U'ї', "i" }, { U'ґ', "g" }, { U'ў', "u" },
+};
+
+// Латиница к одному написанию; сверху вниз, первое подходящее правило
+struct Rule
+{
+    std::string_view from;
+    std::string_view to;
+};
+
+const Rule kLatinRules[] = {
+    { "shch", "sh" }, { "sch", "sh" },
+    { "kh", "h" }, { "ph", "f" }, { "ck", "k" },
+    { "ts", "c" }, { "tz", "c" },
+    { "yo", "e" }, { "jo", "e" }, { "ye", "e" }, { "je", "e" },
+    { "yu", "iu" }, { "ju", "iu" }, { "ya", "ia" }, { "ja", "ia" },
+    { "th", "t" }, { "iy", "i" }, { "ij", "i" },
+    { "y", "i" }, { "j", "i" }, { "w", "v" }, { "q", "k" }, { "x", "ks" },
+};
+
+const char* cyrillicToLatin(char32_t ch)
+{
+    if (ch >= U'а' && ch <= U'я')
+        return kCyrillic[ch - U'а'];
+    for (const Letter& l : kOtherLetters)
+    {
+        if (l.ch == ch)
+            return l.latin;
+    }
+    return nullptr;
+}
+
+bool isLatinLetter(char ch)
+{
+    return ch >= 'a' && ch <= 'z';
+}
+
+} // namespace
+
+void Translit::append(std::string& out, std::string_view text)
+{
+    // 1. сложить регистр и заменить кириллицу
+    const std::string folded = SearchKey::fold(text);
+    std::string latin;
+    latin.reserve(folded.size());
+    for (std::size_t i = 0; i < folded.size();)
+    {
+        const unsigned char b = static_cast<unsigned char>(folded[i]);
+        if ((b == 0xD0 || b == 0xD1 || b == 0xD2) && i + 1 < folded.size())
+        {
+            const char32_t ch = char32_t(b & 0x1F) << 6 | (static_cast<unsigned char>(folded[i + 1]) & 0x3F);
+            if (const char* l = cyrillicToLatin(ch))
+            {
+                latin += l;
+                i += 2;
+                continue;
+            }
+        }
+        latin += folded[i++];
+    }
+
+    // 2. одно написание для латиницы
+    out.reserve(out.size() + latin.size());
+    for (std::size_t i = 0; i < latin.size();)
+    {
+        const Rule* match = nullptr;
+        if (isLatinLetter(latin[i]))
+        {
+            const std::string_view rest = std::string_view(latin).substr(i);
+            for (const Rule& r : kLatinRules)
+            {
+                if (r.from[0] == rest[0] && rest.substr(0, r.from.size()) == r.from)
+                {
+                    match = &r;
+                    break;
+                }
+            }
+        }
+
+        if (match)
+        {
+            out += match->to;
+            i += match->from.size();
+        }
+        else
+        {
+            out += latin[i++];
+        }
+    }
+}
+
+Translit::Script Translit::script(std::string_view text)
+{
+    Script found = Script::None;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+        const unsigned char b = static_cast<unsigned char>(text[i]);
+        if ((b == 0xD0 || b == 0xD1 || b == 0xD2) && i + 1 < text.size())
+            return Script::Cyrillic; // буквы кириллицы U+0400..U+04BF
+        if ((b | 0x20) >= 'a' && (b | 0x20) <= 'z')
+            found = Script::Latin;
+    }
+    return found;
+}
+
+Translit::Script Translit::opposite(Script s)
+{
+    switch (s)
+    {
+    case Script::Latin:    return Script::Cyrillic;
+    case Script::Cyrillic: return Script::Latin;
+    default:               return Script::None;
+    }
+}
+
+std::string Translit::key(std::string_view text)
+{
+    std::string out;
+    append(out, text);
+    return out;
+}
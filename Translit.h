@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Транслитерация для поиска: «Ivanov» и «Иванов» дают один ключ «ivanov».
+//
+// Текст складывается (см. SearchKey), кириллица заменяется латиницей
+// по таблице (ж → zh, х → kh, щ → shch, ь и ъ пропадают), затем латиница
+// приводится к одному написанию по второй таблице: разные системы
+// транслитерации пишут одно и то же по-разному (kh/h, yu/iu, y/j/i, ts/tz,
+// th/t, iy/i, yo/ye/e), в ключе остаётся один вариант
+// («Yuriy», «Yury», «Юрий» → «iuri»; «Fyodor», «Fedor», «Фёдор» → «fedor»).
+// Двойные буквы остаются: «Анна» → «anna», а не «ana» из «Светлана».
+// Остальные символы не меняются. Ключ не для показа — только для сравнения.
+//
+// Ключи сравниваются только между разными письмами: запрос кириллицей ищется
+// в ключах имён, записанных латиницей, и наоборот. Внутри одного письма
+// обычный поиск точнее (и/ы, е/э в ключе совпадают).
+class Translit
+{
+public:
+    enum class Script {
+        None,       // букв нет: цифры, знаки
+        Latin,
+        Cyrillic    // есть хоть одна буква кириллицы
+    };
+
+    static void append(std::string& out, std::string_view text);
+    static std::string key(std::string_view text);
+
+    static Script script(std::string_view text);
+
+    // Письмо, в ключах которого ищется запрос письма s (None → None)
+    static Script opposite(Script s);
+};
@@ -2,6 +2,7 @@
 #include <regex>
 #include <cctype>
 #include <chrono>
+#include <ctime>
 
 // Преобразование UTF-8 → UTF-32 без codecvt
 static std::u32string utf8_to_utf32(const std::string& s)
@@ -214,10 +215,29 @@ bool Validator::isValidEmail(const std::string& raw)
     return true;
 }
 
+Date Validator::today()
+{
+    // localtime() отдаёт общий статический tm — при проверке из нескольких
+    // потоков (импорт) это гонка, поэтому потокобезопасные варианты
+    const std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm{};
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    return Date(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
 // более полная проверка даты, чем в Date::isValid
 bool Validator::isValidBirthDate(const Date& d)
 {
-    if (d.year <= 0 || d.month < 1 || d.month > 12 || d.day < 1)
+    return isValidBirthDate(d, today());
+}
+
+bool Validator::isValidBirthDate(const Date& d, const Date& today)
+{
+    if (d.year() <= 0 || d.month() < 1 || d.month() > 12 || d.day() < 1)
         return false;
 
     auto daysInMonth = [](int year, int month) -> int {
@@ -236,23 +256,49 @@ bool Validator::isValidBirthDate(const Date& d)
         }
     };
 
-    int maxDay = daysInMonth(d.year, d.month);
-    if (d.day > maxDay)
+    int maxDay = daysInMonth(d.year(), d.month());
+    if (d.day() > maxDay)
         return false;
 
     // Дата рождения должна быть < текущей даты
-    using namespace std::chrono;
-    auto now = system_clock::now();
-    std::time_t t = system_clock::to_time_t(now);
-    std::tm* tm = std::localtime(&t);
-
-    int curYear  = tm->tm_year + 1900;
-    int curMonth = tm->tm_mon + 1;
-    int curDay   = tm->tm_mday;
-
-    if (d.year > curYear) return false;
-    if (d.year == curYear && d.month > curMonth) return false;
-    if (d.year == curYear && d.month == curMonth && d.day >= curDay) return false;
+    return d < today;
+}
+
+bool Validator::isValidContact(const Contact& c, std::string* reason)
+{
+    return isValidContact(c, today(), reason);
+}
+
+bool Validator::isValidContact(const Contact& c, const Date& today, std::string* reason)
+{
+    auto fail = [reason](const std::string& why)
+    {
+        if (reason)
+            *reason = why;
+        return false;
+    };
+
+    if (!isValidName(c.lastName()) || !isValidName(c.firstName()))
+        return fail("Фамилия и Имя должны быть корректными.");
+
+    if (!trim(c.middleName()).empty() && !isValidName(c.middleName()))
+        return fail("Отчество введено некорректно.");
+
+    if (!isValidEmail(c.email()))
+        return fail("E-mail введён некорректно.");
+
+    if (!c.birthDate().isValid() || !isValidBirthDate(c.birthDate(), today))
+        return fail("Дата рождения некорректна.");
+
+    if (c.phones().empty())
+        return fail("Нужно указать хотя бы один телефон.");
+
+    for (const auto& ph : c.phones())
+    {
+        const std::string number(ph.number());
+        if (!isValidPhone(number))
+            return fail("Телефон введён в неверном формате: " + number);
+    }
 
     return true;
 }
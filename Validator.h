@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include "Contact.h"
 #include "Date.h"
 
 class Validator
@@ -16,6 +17,18 @@ public:
 
     // Дата рождения (валидная дата + < текущей)
     static bool isValidBirthDate(const Date& d);
+    static bool isValidBirthDate(const Date& d, const Date& today);
+
+    // Контакт целиком — те же правила, что в диалоге редактирования.
+    // При ошибке в reason (если передан) — описание для пользователя
+    static bool isValidContact(const Contact& c, std::string* reason = nullptr);
+
+    // То же с заранее взятой датой «сегодня» — для проверки многих
+    // контактов (в том числе из разных потоков) одной датой
+    static bool isValidContact(const Contact& c, const Date& today, std::string* reason = nullptr);
+
+    // Текущая дата по местному времени; потокобезопасно
+    static Date today();
 
     // Вспомогательное
     static std::string trim(const std::string& s);
@@ -0,0 +1,1077 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <QString>
+
+#include "ContactBlockStore.h"
+#include "ContactBook.h"
+#include "ContactExporter.h"
+#include "ContactImporter.h"
+#include "IncrementalSearch.h"
+#include "ContactParser.h"
+#include "ContactQuery.h"
+#include "NameTrie.h"
+#include "Parallel.h"
+#include "SubstringScan.h"
+#include "SearchKey.h"
+#include "Translit.h"
+
+// Замеры производительности справочника.
+// Запуск: PhoneBookBench [число контактов]
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Счётчик выделений памяти: глобальный operator new только для замеров
+static std::atomic<std::size_t> g_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static std::size_t allocationsSince(std::size_t start)
+{
+    return g_allocations.load(std::memory_order_relaxed) - start;
+}
+
+// Синтетический справочник в текстовом формате contacts.txt
+static std::string makeContactsText(std::size_t count)
+{
+    static const char* lastNames[]  = { "Иванов", "Петров", "Сидоров", "Smith", "Кузнецов" };
+    static const char* firstNames[] = { "Пётр", "Иван", "Анна", "John", "Мария" };
+    static const char* streets[]    = { "Невский пр.", "ул. Ленина", "Main st.", "ул. Мира" };
+
+    std::string text;
+    text.reserve(count * 140);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Contact c(lastNames[i % 5] + std::to_string(i % 1000),
+                  firstNames[(i / 5) % 5],
+                  i % 3 ? "Николаевич" : "",
+                  std::string(streets[i % 4]) + ", д. " + std::to_string(i % 200),
+                  Date::fromString(std::to_string(1950 + i % 60) + "-0"
+                                   + std::to_string(1 + i % 9) + "-1"
+                                   + std::to_string(i % 10)),
+                  "user" + std::to_string(i) + "@mail.ru");
+
+        c.addPhone(PhoneNumber("+7812" + std::to_string(1000000 + i % 9000000), PhoneType::Home));
+        if (i % 2)
+            c.addPhone(PhoneNumber("8(999)" + std::to_string(1000000 + i % 9000000),
+                                   PhoneType::Mobile));
+
+        ContactParser::appendRecord(text, c);
+    }
+
+    return text;
+}
+
+// --- Параллельный разбор по кускам ---------------------------------
+
+void benchParallelLoad(std::size_t count)
+{
+    std::cout << "\n=== BENCH PARALLEL LOAD (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    std::cout << "text size: " << text.size() / (1024 * 1024) << " MB\n";
+
+    double base = 0;
+    for (unsigned threads : { 1u, 2u, 4u, 8u })
+    {
+        std::vector<Contact> out;
+        auto start = Clock::now();
+        bool ok = threads == 1 ? ContactParser::parseAll(begin, end, out)
+                               : ContactParser::parseParallel(begin, end, out, threads);
+        double ms = msSince(start);
+        if (threads == 1)
+            base = ms;
+
+        std::printf("threads %u: %8.1f ms  speedup x%.2f  contacts %zu %s\n",
+                    threads, ms, base / ms, out.size(), ok ? "" : "(FAILED)");
+    }
+
+    // через ContactBook: построчный QTextStream против отображения в память
+    const std::string fileName = "bench_contacts.txt";
+    if (FILE* f = std::fopen(fileName.c_str(), "wb"))
+    {
+        std::fwrite(text.data(), 1, text.size(), f);
+        std::fclose(f);
+    }
+
+    for (LoadMode mode : { LoadMode::Stream, LoadMode::Mapped })
+    {
+        ContactBook book;
+        auto start = Clock::now();
+        book.loadFromFile(fileName, mode);
+        std::printf("ContactBook %-6s: %8.1f ms  contacts %zu\n",
+                    mode == LoadMode::Stream ? "stream" : "mapped",
+                    msSince(start), book.contacts().size());
+    }
+
+    std::remove(fileName.c_str());
+}
+
+// --- Сжатый архив из блоков ---------------------------------------
+
+void benchBlockStore(std::size_t count)
+{
+    std::cout << "\n=== BENCH BLOCK STORE (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    const std::string fileName = "bench_contacts.pbb";
+    auto start = Clock::now();
+    ContactBlockStore::save(contacts, fileName);
+    const double saveMs = msSince(start);
+
+    ContactBlockStore store;
+    store.open(fileName);
+    std::size_t packed = 0;
+    for (const auto& b : store.blocks())
+        packed += b.compressedSize;
+
+    std::printf("save: %8.1f ms  blocks %zu  text %zu KB -> %zu KB (x%.2f)\n",
+                saveMs, store.blocks().size(), text.size() / 1024, packed / 1024,
+                packed ? double(text.size()) / packed : 0.0);
+
+    {
+        std::vector<Contact> out;
+        start = Clock::now();
+        store.loadAll(out);
+        std::printf("load all:     %8.1f ms  contacts %zu\n", msSince(start), out.size());
+    }
+    if (!contacts.empty())
+    {
+        std::vector<Contact> out;
+        start = Clock::now();
+        store.findByLastName(contacts[count / 2].lastName(), out);
+        std::printf("by last name: %8.3f ms  contacts %zu\n", msSince(start), out.size());
+    }
+
+    store.close();
+    std::remove(fileName.c_str());
+}
+
+// --- Потоковый импорт CSV --------------------------------------------
+
+void benchImportCsv(std::size_t count)
+{
+    std::cout << "\n=== BENCH IMPORT CSV (" << count << " rows) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    const std::string fileName = "bench_import.csv";
+    std::size_t bytes = 0;
+    if (FILE* f = std::fopen(fileName.c_str(), "wb"))
+    {
+        std::string csv = "last_name,first_name,middle_name,address,birth_date,email,phones\n";
+        for (const auto& c : contacts)
+        {
+            csv += c.lastName() + ',' + c.firstName() + ',' + c.middleName() + ",\""
+                 + c.address() + "\"," + c.birthDate().toString() + ',' + c.email() + ',';
+            for (std::size_t i = 0; i < c.phones().size(); ++i)
+            {
+                csv += i ? ";" : "";
+                csv += c.phones()[i].number();
+            }
+            csv += '\n';
+
+            if (csv.size() > (1 << 20))
+            {
+                bytes += std::fwrite(csv.data(), 1, csv.size(), f);
+                csv.clear();
+            }
+        }
+        bytes += std::fwrite(csv.data(), 1, csv.size(), f);
+        std::fclose(f);
+    }
+    contacts = std::vector<Contact>();
+
+    std::cout << "csv size: " << bytes / (1024 * 1024) << " MB\n";
+
+    for (unsigned threads : { 1u, 4u })
+    {
+        ContactImporter::Stats stats;
+        auto start = Clock::now();
+        ContactImporter::importFile(fileName, ImportFormat::Csv,
+                                    [](std::vector<Contact>&&) { return true; },
+                                    nullptr, &stats,
+                                    ContactImporter::kDefaultBatchSize, threads);
+        std::printf("threads %u: %8.1f ms  accepted %zu  rejected %zu\n",
+                    threads, msSince(start), stats.accepted, stats.rejected);
+    }
+
+    std::remove(fileName.c_str());
+}
+
+// --- Экспорт ---------------------------------------------------------
+
+void benchExport(std::size_t count)
+{
+    std::cout << "\n=== BENCH EXPORT (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    const struct { ExportFormat format; const char* name; const char* file; } formats[] = {
+        { ExportFormat::Csv,       "csv",   "bench_export.csv" },
+        { ExportFormat::VCard,     "vcard", "bench_export.vcf" },
+        { ExportFormat::JsonLines, "jsonl", "bench_export.jsonl" },
+    };
+
+    for (const auto& f : formats)
+    {
+        auto start = Clock::now();
+        bool ok = ContactExporter::exportFile(contacts, f.file, f.format);
+        const double ms = msSince(start);
+
+        std::size_t bytes = 0;
+        if (FILE* in = std::fopen(f.file, "rb"))
+        {
+            std::fseek(in, 0, SEEK_END);
+            bytes = static_cast<std::size_t>(std::ftell(in));
+            std::fclose(in);
+        }
+
+        std::printf("%-5s: %8.1f ms  %6zu MB  %7.1f MB/s %s\n", f.name, ms,
+                    bytes / (1024 * 1024), bytes / (1024.0 * 1024.0) / (ms / 1000.0),
+                    ok ? "" : "(FAILED)");
+        std::remove(f.file);
+    }
+}
+
+// --- Интернирование строк ---------------------------------------------
+
+void benchStringInterning(std::size_t count)
+{
+    std::cout << "\n=== BENCH STRING INTERNING (" << count << " contacts) ===\n";
+
+    const std::string fileName = "bench_contacts.txt";
+    const std::string text = makeContactsText(count);
+    if (FILE* f = std::fopen(fileName.c_str(), "wb"))
+    {
+        std::fwrite(text.data(), 1, text.size(), f);
+        std::fclose(f);
+    }
+
+    for (bool intern : { false, true })
+    {
+        ContactBook book;
+        book.setStringInterning(intern);
+
+        auto start = Clock::now();
+        book.loadFromFile(fileName);
+        std::printf("interning %-3s: load %8.1f ms\n", intern ? "on" : "off", msSince(start));
+
+        std::size_t plain = 0;
+        std::size_t shared = 0;
+        for (const auto& st : book.stringStats())
+        {
+            std::printf("  %-12s values %9zu  unique %9zu  %8zu KB -> %8zu KB\n",
+                        st.field.c_str(), st.values, st.unique,
+                        st.plainBytes / 1024, st.sharedBytes / 1024);
+            plain += st.plainBytes;
+            shared += st.sharedBytes;
+        }
+        std::printf("  total: %zu KB as std::string, %zu KB now (x%.2f)\n",
+                    plain / 1024, shared / 1024, shared ? double(plain) / shared : 0.0);
+    }
+
+    std::remove(fileName.c_str());
+}
+
+// --- Столбцовый поиск и сортировка -------------------------------------
+
+void benchColumns(std::size_t count)
+{
+    std::cout << "\n=== BENCH COLUMNS (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.setSearchIndex(false); // здесь сравнивается просмотр столбцов
+    for (const auto& c : contacts)
+        book.addContact(c);
+
+    auto start = Clock::now();
+    book.columns();
+    std::printf("build columns:       %8.1f ms\n", msSince(start));
+
+    for (const char* needle : { "user12345@", "Петров7", "99912" })
+    {
+        // как искали раньше: по объектам Contact целиком
+        start = Clock::now();
+        std::size_t rows = 0;
+        for (const auto& c : contacts)
+        {
+            bool match = c.lastName().find(needle) != std::string::npos
+                      || c.firstName().find(needle) != std::string::npos
+                      || c.middleName().find(needle) != std::string::npos
+                      || c.email().find(needle) != std::string::npos
+                      || c.address().find(needle) != std::string::npos;
+            for (const auto& ph : c.phones())
+                match = match || ph.number().find(needle) != std::string::npos;
+            rows += match;
+        }
+        const double rowMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t found = book.find(needle).size();
+        const double colMs = msSince(start);
+
+        std::printf("find %-12s rows %7.1f ms  columns %7.1f ms  (x%.2f)  found %zu/%zu\n",
+                    needle, rowMs, colMs, colMs > 0 ? rowMs / colMs : 0.0, found, rows);
+    }
+
+    for (SortField field : { SortField::BirthDate, SortField::LastName })
+    {
+        start = Clock::now();
+        book.sortBy(field, true);
+        std::printf("sort by %-10s %8.1f ms\n",
+                    field == SortField::BirthDate ? "date:" : "last name:", msSince(start));
+    }
+}
+
+// --- Телефоны без кучи --------------------------------------------------
+
+void benchPhoneStorage(std::size_t count)
+{
+    std::cout << "\n=== BENCH PHONE STORAGE (" << count << " contacts) ===\n";
+    std::printf("sizeof(PhoneNumber) %zu, sizeof(Contact) %zu\n",
+                sizeof(PhoneNumber), sizeof(Contact));
+
+    const std::string text = makeContactsText(count);
+
+    std::vector<Contact> contacts;
+    auto start = Clock::now();
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+    std::printf("parse:         %8.1f ms\n", msSince(start));
+
+    start = Clock::now();
+    std::vector<Contact> copy = contacts;
+    std::printf("copy all:      %8.1f ms\n", msSince(start));
+
+    ContactBook book;
+    start = Clock::now();
+    for (const auto& c : contacts)
+        book.addContact(c);
+    std::printf("addContact:    %8.1f ms\n", msSince(start));
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < contacts.size(); ++i)
+        book.updateContact(i, copy[contacts.size() - 1 - i]);
+    std::printf("updateContact: %8.1f ms\n", msSince(start));
+}
+
+// --- Даты ---------------------------------------------------------------
+
+void benchDates(std::size_t count)
+{
+    std::cout << "\n=== BENCH DATES (" << count << " dates) ===\n";
+
+    std::vector<std::string> texts;
+    texts.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+        texts.push_back(Date(1950 + int(i % 60), 1 + int(i % 12), 1 + int(i % 28)).toString());
+
+    // как было: через потоки
+    auto start = Clock::now();
+    std::size_t check = 0;
+    for (const auto& t : texts)
+    {
+        int y = 0, m = 0, d = 0;
+        char dash1 = 0, dash2 = 0;
+        std::istringstream is(t);
+        is >> y >> dash1 >> m >> dash2 >> d;
+
+        std::ostringstream os;
+        os << std::setfill('0') << std::setw(4) << y << "-"
+           << std::setw(2) << m << "-" << std::setw(2) << d;
+        check += os.str().size();
+    }
+    std::printf("streams:             %8.1f ms\n", msSince(start));
+
+    start = Clock::now();
+    for (const auto& t : texts)
+        check += Date::fromString(t).toString().size();
+    std::printf("fromString/toString: %8.1f ms\n", msSince(start));
+
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    std::vector<Date> dates(count);
+    std::string column(count * Date::kIsoLength, '\0');
+    start = Clock::now();
+    Date::parseIso(views.data(), count, dates.data());
+    Date::formatIso(dates.data(), count, &column[0]);
+    std::printf("column batch:        %8.1f ms\n", msSince(start));
+
+    start = Clock::now();
+    std::sort(dates.begin(), dates.end());
+    std::printf("sort:                %8.1f ms  (%zu)\n", msSince(start), check);
+}
+
+// --- Канонические номера -------------------------------------------------
+
+void benchPhoneKeys(std::size_t count)
+{
+    std::cout << "\n=== BENCH PHONE KEYS (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    std::vector<PhoneNumber> phones;
+    for (const auto& c : contacts)
+        for (const auto& ph : c.phones())
+            phones.push_back(ph);
+
+    // как пришлось бы без ключа: нормализовать текст в строку цифр
+    auto start = Clock::now();
+    std::unordered_set<std::string> byText;
+    for (const auto& ph : phones)
+    {
+        std::string digits;
+        for (char ch : ph.number())
+            if (ch >= '0' && ch <= '9')
+                digits += ch;
+        if (digits.size() == 11 && digits[0] == '8')
+            digits[0] = '7';
+        byText.insert(digits);
+    }
+    std::printf("dedup by digit string: %8.1f ms  unique %zu\n", msSince(start), byText.size());
+
+    start = Clock::now();
+    std::unordered_set<std::uint64_t> byKey;
+    for (const auto& ph : phones)
+        byKey.insert(ph.canonical());
+    std::printf("dedup by key:          %8.1f ms  unique %zu\n", msSince(start), byKey.size());
+
+    start = Clock::now();
+    std::sort(phones.begin(), phones.end());
+    std::printf("sort %zu phones:     %8.1f ms\n", phones.size(), msSince(start));
+
+    ContactBook book;
+    for (const auto& c : contacts)
+        book.addContact(c);
+    book.columns();
+    start = Clock::now();
+    const std::size_t found = book.findByPhone("8(812)100-01-23").size();
+    std::printf("findByPhone:           %8.3f ms  found %zu\n", msSince(start), found);
+}
+
+// --- Удаление контактов --------------------------------------------------
+
+void benchRemove(std::size_t count)
+{
+    std::cout << "\n=== BENCH REMOVE (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+    const std::size_t removals = std::min<std::size_t>(count / 2, 1000);
+
+    // как было: erase со сдвигом всех следующих контактов
+    std::vector<Contact> plain = contacts;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < removals; ++i)
+        plain.erase(plain.begin() + static_cast<long>((i * 7919) % plain.size()));
+    std::printf("vector erase x%zu: %9.1f ms\n", removals, msSince(start));
+
+    ContactBook book;
+    std::vector<ContactHandle> handles;
+    for (const auto& c : contacts)
+        handles.push_back(book.addContact(c));
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < removals; ++i)
+        book.removeContact(handles[(i * 7919) % handles.size()]);
+    std::printf("handle remove x%zu: %8.1f ms  left %zu\n",
+                removals, msSince(start), book.contacts().size());
+
+    // те же удаления пачкой: contacts() сдвигается один раз
+    ContactBook batched;
+    handles.clear();
+    batched.addContacts(contacts, &handles);
+    std::vector<ContactChange> changes;
+    for (std::size_t i = 0; i < removals; ++i)
+        changes.push_back(ContactChange::remove(handles[(i * 7919) % handles.size()]));
+
+    start = Clock::now();
+    batched.applyChanges(std::move(changes));
+    std::printf("batch remove x%zu: %9.1f ms  left %zu\n",
+                removals, msSince(start), batched.contacts().size());
+}
+
+// --- Индекс триграмм ----------------------------------------------------
+
+void benchSearchIndex(std::size_t count)
+{
+    std::cout << "\n=== BENCH SEARCH INDEX (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook scan;
+    scan.setSearchIndex(false);
+    scan.addContacts(contacts);
+    scan.columns();
+
+    ContactBook indexed;
+    indexed.addContacts(std::move(contacts));
+
+    auto start = Clock::now();
+    const ContactIndex& index = indexed.index();
+    std::printf("build index:         %8.1f ms  %zu trigrams, %zu postings (%.1f MB)\n",
+                msSince(start), index.gramCount(), index.postingCount(),
+                index.postingCount() * sizeof(std::uint32_t) / 1048576.0);
+
+    // ввод по буквам, как в строке фильтра
+    for (const char* needle : { "Иван", "Иванов", "Иванов12", "user12345@", "ул. Мира, д. 17",
+                                "99912", "+78121001234" })
+    {
+        start = Clock::now();
+        const std::size_t scanned = scan.find(needle).size();
+        const double scanMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t found = indexed.find(needle).size();
+        const double indexMs = msSince(start);
+
+        std::printf("find %-22s scan %7.2f ms  index %7.3f ms  (x%.0f)  found %zu/%zu\n",
+                    needle, scanMs, indexMs, indexMs > 0 ? scanMs / indexMs : 0.0, found, scanned);
+    }
+
+    // правка после построения — индекс дополняется, а не строится заново
+    start = Clock::now();
+    for (std::size_t i = 0; i < 1000 && i < indexed.contacts().size(); ++i)
+    {
+        Contact c = indexed.contacts()[i];
+        c.setFirstName("Изменённый");
+        indexed.updateContact(indexed.handleAt(i), std::move(c));
+    }
+    std::printf("update x1000 + find: %8.1f ms  found %zu\n",
+                msSince(start), indexed.find("Изменённый").size());
+}
+
+// --- Фильтр таблицы без учёта регистра ---------------------------------
+
+void benchCaseFolding(std::size_t count)
+{
+    std::cout << "\n=== BENCH CASE FOLDING (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    auto start = Clock::now();
+    ContactBook book;
+    book.addContacts(contacts);
+    std::printf("add with search keys: %7.1f ms\n", msSince(start));
+
+    start = Clock::now();
+    book.index();
+    std::printf("build index:          %7.1f ms\n", msSince(start));
+
+    ContactBook scan;
+    scan.setSearchIndex(false);
+    scan.addContacts(contacts);
+
+    for (const char* needle : { "ив", "ИВАНОВ12", "user12345@", "НЕВСКИЙ ПР., Д. 17" })
+    {
+        // как фильтровала таблица: строка на контакт, toLower, contains
+        start = Clock::now();
+        const QString f = QString::fromStdString(needle).toLower();
+        std::size_t rows = 0;
+        for (const auto& c : contacts)
+        {
+            QString all = QString::fromStdString(c.lastName() + " " + c.firstName() + " "
+                                                 + c.middleName() + " " + c.address() + " "
+                                                 + c.email());
+            for (const auto& ph : c.phones())
+                all += " " + QString::fromStdString(std::string(ph.number()));
+            rows += all.toLower().contains(f);
+        }
+        const double qtMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t scanned = scan.find(needle).size();
+        const double keyMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t found = book.find(needle).size();
+        const double indexMs = msSince(start);
+
+        std::printf("filter %-32s QString %7.1f ms  keys %7.2f ms  index %7.3f ms  found %zu/%zu/%zu\n",
+                    needle, qtMs, keyMs, indexMs, rows, scanned, found);
+    }
+}
+
+// --- Поиск по цифрам номера --------------------------------------------
+
+void benchPhoneDigits(std::size_t count)
+{
+    std::cout << "\n=== BENCH PHONE DIGITS (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook scan;
+    scan.setSearchIndex(false);
+    scan.addContacts(contacts);
+
+    ContactBook indexed;
+    indexed.addContacts(std::move(contacts));
+    auto start = Clock::now();
+    indexed.index();
+    std::printf("build index:          %7.1f ms\n", msSince(start));
+
+    struct Query { const char* digits; DigitMatch match; const char* name; };
+    for (const Query& q : { Query{ "1001234", DigitMatch::Infix, "infix" },
+                            Query{ "812100", DigitMatch::Infix, "infix" },
+                            Query{ "7999100", DigitMatch::Prefix, "prefix" },
+                            Query{ "01234", DigitMatch::Suffix, "suffix" } })
+    {
+        start = Clock::now();
+        const std::size_t scanned = scan.findByDigits(q.digits, q.match).size();
+        const double scanMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t found = indexed.findByDigits(q.digits, q.match).size();
+        const double indexMs = msSince(start);
+
+        std::printf("%-6s %-8s scan %7.2f ms  index %7.3f ms  found %zu/%zu\n",
+                    q.name, q.digits, scanMs, indexMs, found, scanned);
+    }
+}
+
+// --- Поиск по мере ввода ----------------------------------------------
+
+void benchTypeAhead(std::size_t count)
+{
+    std::cout << "\n=== BENCH TYPE-AHEAD (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+    book.index();
+
+    // по букве, как в строке поиска; «буква» UTF-8 — 1 или 2 байта
+    const std::string word = "кузнецов12@";
+    std::vector<std::string> typed;
+    for (std::size_t i = 0; i < word.size();)
+    {
+        i += static_cast<unsigned char>(word[i]) < 0x80 ? 1 : 2;
+        typed.push_back(word.substr(0, i));
+    }
+    for (std::size_t i = typed.size() - 1; i-- > 0;)
+        typed.push_back(typed[i]); // стираем обратно
+
+    IncrementalSearch search(book);
+    double fullTotal = 0;
+    double typeTotal = 0;
+    for (const auto& q : typed)
+    {
+        auto start = Clock::now();
+        const std::size_t full = book.find(q).size();
+        const double fullMs = msSince(start);
+
+        start = Clock::now();
+        const std::size_t found = search.search(q).size();
+        const double typeMs = msSince(start);
+
+        fullTotal += fullMs;
+        typeTotal += typeMs;
+        const char* step = search.lastStep() == IncrementalSearch::Step::Full    ? "full"
+                         : search.lastStep() == IncrementalSearch::Step::Refined ? "refine" : "cached";
+        std::printf("%-16s find %7.2f ms  type-ahead %7.3f ms %-6s  found %zu/%zu\n",
+                    q.c_str(), fullMs, typeMs, step, found, full);
+    }
+    std::printf("total: find %.1f ms, type-ahead %.1f ms\n", fullTotal, typeTotal);
+}
+
+// --- Пакетное добавление и изменение ------------------------------------
+
+void benchBulkAdd(std::size_t count)
+{
+    std::cout << "\n=== BENCH BULK ADD (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    // как было: по одному, с копированием каждого контакта
+    {
+        std::vector<Contact> batch = contacts;
+        ContactBook book;
+        const std::size_t allocs = g_allocations.load();
+        auto start = Clock::now();
+        for (const auto& c : batch)
+            book.addContact(c);
+        std::printf("addContact(copy):   %8.1f ms  %9zu allocations\n",
+                    msSince(start), allocationsSince(allocs));
+    }
+
+    {
+        std::vector<Contact> batch = contacts;
+        ContactBook book;
+        const std::size_t allocs = g_allocations.load();
+        auto start = Clock::now();
+        book.addContacts(std::move(batch));
+        std::printf("addContacts(move):  %8.1f ms  %9zu allocations\n",
+                    msSince(start), allocationsSince(allocs));
+    }
+
+    // изменить каждый десятый контакт: по одному с копией и одной пачкой
+    const std::size_t step = 10;
+    {
+        ContactBook book;
+        book.addContacts(std::vector<Contact>(contacts));
+        std::vector<Contact> edits;
+        for (std::size_t i = 0; i < count; i += step)
+            edits.push_back(contacts[i]);
+
+        const std::size_t allocs = g_allocations.load();
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < edits.size(); ++i)
+            book.updateContact(book.handleAt(i * step), edits[i]);
+        book.find("Иванов1");
+        std::printf("updateContact x%-6zu %8.1f ms  %9zu allocations\n",
+                    edits.size(), msSince(start), allocationsSince(allocs));
+    }
+
+    {
+        ContactBook book;
+        book.addContacts(std::vector<Contact>(contacts));
+        std::vector<ContactChange> changes;
+        for (std::size_t i = 0; i < count; i += step)
+            changes.push_back(ContactChange::update(book.handleAt(i), contacts[i]));
+
+        const std::size_t edits = changes.size();
+        const std::size_t allocs = g_allocations.load();
+        auto start = Clock::now();
+        book.applyChanges(std::move(changes));
+        book.find("Иванов1");
+        std::printf("applyChanges x%-7zu %8.1f ms  %9zu allocations\n",
+                    edits, msSince(start), allocationsSince(allocs));
+    }
+}
+
+void benchSubstringScan(std::size_t count)
+{
+    std::cout << "\n=== BENCH SUBSTRING SCAN (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+
+    // те же ключи, что у поиска без индекса, одним буфером
+    std::string keys;
+    std::vector<std::size_t> offsets(1, 0);
+    for (std::size_t i = 0; i < book.contacts().size(); ++i)
+    {
+        keys += book.searchKey(i);
+        offsets.push_back(keys.size());
+    }
+    std::printf("key text: %.1f MB, best kernel: %s\n", keys.size() / 1e6,
+                SubstringScan::name(SubstringScan::best()));
+
+    const SubstringScan::Kernel kernels[] = {
+        SubstringScan::Kernel::Scalar, SubstringScan::Kernel::Sse2, SubstringScan::Kernel::Avx2
+    };
+    const char* needles[] = { "ив", "кузнецов", "@mail", "x", "нет такого" };
+    for (const char* needle : needles)
+    {
+        std::vector<std::size_t> found;
+        std::vector<std::size_t> expected;
+        for (SubstringScan::Kernel kernel : kernels)
+        {
+            if (!SubstringScan::supported(kernel))
+                continue;
+            const auto start = Clock::now();
+            SubstringScan::scan(keys, offsets, needle, found, kernel);
+            const double ms = msSince(start);
+            if (kernel == SubstringScan::Kernel::Scalar)
+                expected = found;
+            std::printf("%-12s %-6s %7.2f ms %8.0f MB/s  found %zu%s\n", needle, SubstringScan::name(kernel),
+                        ms, keys.size() / 1e3 / ms, found.size(), found == expected ? "" : "  MISMATCH");
+        }
+    }
+}
+
+// Расстояние Левенштейна «в лоб» — для сравнения с обходом словаря
+static unsigned editDistance(const std::u32string& a, const std::u32string& b)
+{
+    std::vector<unsigned> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j)
+        row[j] = static_cast<unsigned>(j);
+    for (std::size_t i = 1; i <= a.size(); ++i)
+    {
+        unsigned diag = row[0];
+        row[0] = static_cast<unsigned>(i);
+        for (std::size_t j = 1; j <= b.size(); ++j)
+        {
+            const unsigned up = row[j];
+            row[j] = std::min({ row[j] + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1]) });
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+void benchFuzzySearch(std::size_t count)
+{
+    std::cout << "\n=== BENCH FUZZY SEARCH (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+
+    auto start = Clock::now();
+    book.findFuzzy("x");
+    std::printf("name dictionary: %.1f ms\n", msSince(start));
+
+    for (const char* query : { "Кузнецав12", "Иванов7", "Smyth345", "Сидоров 1ван", "Пётр" })
+    {
+        start = Clock::now();
+        const std::vector<FuzzyMatch> found = book.findFuzzy(query, 20);
+        const double ms = msSince(start);
+
+        // тот же запрос перебором фамилий всех контактов (только первое слово)
+        const std::u32string word = NameTrie::words(query).front();
+        const unsigned limit = ContactBook::maxTypos(word.size());
+        start = Clock::now();
+        std::size_t bruteHits = 0;
+        for (const Contact& c : book.contacts())
+        {
+            const auto words = NameTrie::words(c.lastName());
+            if (!words.empty() && editDistance(word, words.front()) <= limit)
+                ++bruteHits;
+        }
+        const double bruteMs = msSince(start);
+
+        std::printf("%-22s trie %7.3f ms  top %zu (best %u typos)   brute force %8.1f ms  hits %zu\n",
+                    query, ms, found.size(), found.empty() ? 0u : found.front().distance, bruteMs, bruteHits);
+    }
+}
+
+void benchContactQuery(std::size_t count)
+{
+    std::cout << "\n=== BENCH CONTACT QUERY (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+    book.index();
+
+    static const char* accessNames[] = { "find", "trigram", "phone digits", "birth date" };
+    const char* queries[] = {
+        "last:кузнецов14 born:1960..1970",
+        "phone:81210123 type:home",
+        "born:1975-02-15",
+        "email:user123 last:smith",
+        "first:мария middle:николаевич born:1990..",
+        "кузнецов1 address:мира",
+    };
+
+    std::vector<ContactQuery> parsed(std::size(queries));
+    std::vector<std::size_t> found(std::size(queries));
+    std::vector<double> indexedMs(std::size(queries));
+    for (std::size_t q = 0; q < parsed.size(); ++q)
+    {
+        ContactQuery::parse(queries[q], parsed[q]);
+        book.findQuery(parsed[q]); // порядок дат строится при первом born:
+
+        const auto start = Clock::now();
+        found[q] = book.findQuery(parsed[q]).size();
+        indexedMs[q] = msSince(start);
+    }
+
+    std::vector<QueryPlan> plans;
+    for (const auto& q : parsed)
+        plans.push_back(book.planQuery(q));
+
+    book.setSearchIndex(false);
+    for (std::size_t q = 0; q < parsed.size(); ++q)
+    {
+        const auto start = Clock::now();
+        const std::size_t scanned = book.findQuery(parsed[q]).size();
+        const double scanMs = msSince(start);
+
+        const char* first = plans[q].steps.empty() ? "scan"
+                          : accessNames[static_cast<int>(plans[q].steps[0].access)];
+        std::printf("%-44s plan %-12s %8.3f ms   scan %7.1f ms   found %zu%s\n", queries[q], first,
+                    indexedMs[q], scanMs, found[q], scanned == found[q] ? "" : "  MISMATCH");
+    }
+}
+
+void benchParallelSearch(std::size_t count)
+{
+    std::cout << "\n=== BENCH PARALLEL SEARCH (" << count << " contacts, " << Parallel::workerCount() << " cores) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+    book.setSearchIndex(false);
+    book.find("x"); // буфер ключей
+
+    for (const char* needle : { "кузнецов12", "@mail", "нет такого" })
+    {
+        double base = 0;
+        for (unsigned threads : { 1u, 2u, 4u, 8u })
+        {
+            book.setSearchThreads(threads);
+            const auto start = Clock::now();
+            const std::size_t found = book.find(needle).size();
+            const double ms = msSince(start);
+            if (threads == 1)
+                base = ms;
+            std::printf("%-12s threads %u: %7.2f ms  speedup x%.2f  found %zu\n", needle, threads, ms, base / ms, found);
+        }
+    }
+
+    // отмена: запрос устарел, пока шёл поиск
+    book.setSearchThreads(0);
+    std::atomic<bool> cancel{false};
+    Clock::time_point stoppedAt;
+    bool finished = true;
+    std::thread worker([&]()
+    {
+        std::vector<std::size_t> out;
+        finished = book.find("нет такого", out, cancel);
+        stoppedAt = Clock::now();
+    });
+    std::this_thread::sleep_for(std::chrono::microseconds(500));
+    const Clock::time_point cancelledAt = Clock::now();
+    cancel = true;
+    worker.join();
+    std::printf("cancel: %s, stopped %.3f ms after the flag\n", finished ? "finished first" : "stopped",
+                std::chrono::duration<double, std::milli>(stoppedAt - cancelledAt).count());
+}
+
+void benchTranslit(std::size_t count)
+{
+    std::cout << "\n=== BENCH TRANSLIT (" << count << " contacts) ===\n";
+
+    const std::string text = makeContactsText(count);
+    std::vector<Contact> contacts;
+    ContactParser::parseAll(text.data(), text.data() + text.size(), contacts);
+
+    // ключи строятся один раз на контакт — рядом с обычным ключом поиска
+    auto start = Clock::now();
+    std::size_t bytes = 0;
+    for (const Contact& c : contacts)
+        bytes += SearchKey::build(c).size();
+    const double keyMs = msSince(start);
+    start = Clock::now();
+    std::size_t translitBytes = 0;
+    for (const Contact& c : contacts)
+        translitBytes += SearchKey::buildTranslit(c).text.size();
+    std::printf("search keys %.1f ms (%zu bytes)   translit keys %.1f ms (%zu bytes)\n",
+                keyMs, bytes, msSince(start), translitBytes);
+
+    ContactBook book;
+    book.addContacts(std::move(contacts));
+    start = Clock::now();
+    const ContactIndex& index = book.index();
+    std::printf("index build %.1f ms: %zu grams, %zu postings\n",
+                msSince(start), index.gramCount(), index.postingCount());
+
+    // латиницей по кириллице и наоборот; для сравнения — тот же запрос без индекса
+    const char* queries[] = { "Kuznetsov12", "Ivanov7", "Смит343", "Nikolaevich", "Иванов7" };
+    std::vector<double> indexMs;
+    std::vector<std::size_t> indexFound;
+    for (const char* query : queries)
+    {
+        start = Clock::now();
+        indexFound.push_back(book.find(query).size());
+        indexMs.push_back(msSince(start));
+    }
+
+    book.setSearchIndex(false);
+    book.find("x"); // буферы ключей
+    for (std::size_t k = 0; k < std::size(queries); ++k)
+    {
+        start = Clock::now();
+        const std::size_t found = book.find(queries[k]).size();
+        std::printf("%-14s index %7.3f ms  found %zu   scan %7.2f ms  found %zu\n",
+                    queries[k], indexMs[k], indexFound[k], msSince(start), found);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 500000;
+
+    benchParallelLoad(count);
+    benchBlockStore(count);
+    benchImportCsv(count);
+    benchExport(count);
+    benchStringInterning(count);
+    benchColumns(count);
+    benchPhoneStorage(count);
+    benchDates(count);
+    benchPhoneKeys(count);
+    benchRemove(count);
+    benchBulkAdd(count);
+    benchSearchIndex(count);
+    benchCaseFolding(count);
+    benchPhoneDigits(count);
+    benchTypeAhead(count);
+    benchSubstringScan(count);
+    benchFuzzySearch(count);
+    benchContactQuery(count);
+    benchParallelSearch(count);
+    benchTranslit(count);
+
+    std::cout << "\n=== BENCHMARKS FINISHED ===\n";
+    return 0;
+}
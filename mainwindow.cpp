@@ -1,5 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "ContactQuery.h"
+#include "ContactSnapshot.h"
 
 #include <QCoreApplication>
 #include <QTableWidgetItem>
@@ -21,8 +23,115 @@
 #include <QListWidget>
 #include <QPushButton>
 #include <QHBoxLayout>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QSemaphore>
+#include <QMetaObject>
+#include <QStatusBar>
+#include <QFileDialog>
+#include <algorithm>
+#include <memory>
 
 
+// размер журнала, после которого он сворачивается в contacts.txt
+static const qint64 kJournalCompactSize = 4 * 1024 * 1024;
+
+// окно, в котором запросы на запись файла сливаются в одну (мс)
+static const int kSaveDelayMs = 500;
+
+// сколько контактов передаётся в таблицу за раз при фоновой загрузке
+static const std::size_t kLoadBatchSize = 10000;
+
+// сколько порций импорта может ждать таблицу: дальше поток импорта
+// ждёт, пока окно их разберёт, и файл не оседает в памяти целиком
+static const int kImportBatchesInFlight = 4;
+
+// сколько отклонённых строк показать в итоговом сообщении импорта (остальные — в отчёте)
+static const int kImportSampleRejections = 10;
+
+// номер телефона хранится в PhoneNumber без std::string
+static QString phoneText(const PhoneNumber &ph)
+{
+    const std::string_view n = ph.number();
+    return QString::fromUtf8(n.data(), static_cast<int>(n.size()));
+}
+
+// Порция импорта в БД одной транзакцией; контакт с e-mail, который в БД
+// уже есть, пропускается. Возвращает, сколько контактов не записано.
+static std::size_t insertBatchToDb(QSqlDatabase &db, const std::vector<Contact> &batch)
+{
+    if (!db.transaction()) {
+        qDebug() << "import transaction start failed:" << db.lastError().text();
+        return batch.size();
+    }
+
+    QSqlQuery q(db);
+    q.prepare(R"(
+        INSERT INTO contacts(last_name, first_name, middle_name, address, birth_date, email)
+        VALUES(:ln, :fn, :mn, :adr, :bd, :em)
+        ON CONFLICT (email) DO NOTHING
+        RETURNING id;
+    )");
+
+    QSqlQuery qp(db);
+    qp.prepare(R"(
+        INSERT INTO phones(contact_id, number, type)
+        VALUES(:cid, :num, :typ);
+    )");
+
+    std::size_t skipped = 0;
+    for (const auto &c : batch) {
+        q.bindValue(":ln",  QString::fromStdString(c.lastName()));
+        q.bindValue(":fn",  QString::fromStdString(c.firstName()));
+        q.bindValue(":mn",  QString::fromStdString(c.middleName()));
+        q.bindValue(":adr", QString::fromStdString(c.address()));
+        q.bindValue(":bd",  QString::fromStdString(c.birthDate().toString()));
+        q.bindValue(":em",  QString::fromStdString(c.email()));
+
+        if (!q.exec()) {
+            qDebug() << "import contact failed:" << q.lastError().text();
+            db.rollback();
+            return batch.size();
+        }
+        if (!q.next()) {
+            ++skipped;
+            continue;
+        }
+
+        const int newId = q.value(0).toInt();
+        for (const auto &ph : c.phones()) {
+            qp.bindValue(":cid", newId);
+            qp.bindValue(":num", phoneText(ph));
+            qp.bindValue(":typ", QString::fromStdString(PhoneNumber::typeToString(ph.type())));
+
+            if (!qp.exec()) {
+                qDebug() << "import phone failed:" << qp.lastError().text();
+                db.rollback();
+                return batch.size();
+            }
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "import commit failed:" << db.lastError().text();
+        db.rollback();
+        return batch.size();
+    }
+
+    return skipped;
+}
+
+// Итоги фонового импорта: пишутся в потоке импорта,
+// читаются после завершения потока
+struct ImportResult
+{
+    bool ok = false;
+    ContactImporter::Stats stats;
+    std::size_t notSaved = 0;     // не записались в БД (например, такой e-mail уже есть)
+    QStringList samples;
+};
+
 //  Диалог ввода/редактирования контакта
 
 class ContactDialog : public QDialog
@@ -104,8 +213,8 @@ public:
         m_middleNameEdit->setText(QString::fromStdString(c.middleName()));
         m_addressEdit->setText(QString::fromStdString(c.address()));
 
-        const std::string ds = c.birthDate().toString();
-        QDate qd = QDate::fromString(QString::fromStdString(ds), "yyyy-MM-dd");
+        const Date bd = c.birthDate();
+        QDate qd(bd.year(), bd.month(), bd.day());
         if (!qd.isValid())
             qd = QDate(2000, 1, 1);
         m_birthDateEdit->setDate(qd);
@@ -115,12 +224,12 @@ public:
         m_phoneList->clear();
         const auto &phones = c.phones();
         for (const auto &ph : phones) {
-            addPhoneToList(QString::fromStdString(ph.number()),
+            addPhoneToList(phoneText(ph),
                            QString::fromStdString(PhoneNumber::typeToString(ph.type())));
         }
 
         if (!phones.empty()) {
-            m_phoneEdit->setText(QString::fromStdString(phones[0].number()));
+            m_phoneEdit->setText(phoneText(phones[0]));
             QString typeStr = QString::fromStdString(PhoneNumber::typeToString(phones[0].type()));
             int idx = m_phoneTypeBox->findText(typeStr);
             if (idx >= 0) m_phoneTypeBox->setCurrentIndex(idx);
@@ -166,7 +275,7 @@ protected:
         }
 
         QDate qd = m_birthDateEdit->date();
-        Date d = Date::fromString(qd.toString("yyyy-MM-dd").toStdString());
+        Date d(qd.year(), qd.month(), qd.day());
         if (!d.isValid() || !Validator::isValidBirthDate(d))
         {
             QMessageBox::warning(this, tr("Ошибка"),
@@ -222,10 +331,14 @@ private:
 
         QString pt = m_phoneTypeBox->currentText();
 
+        // «+78121234567» и «8(812)123-45-67» — один и тот же телефон
+        const PhoneNumber added(ph.toStdString(), PhoneNumber::stringToType(pt.toStdString()));
         for (int i = 0; i < m_phoneList->count(); ++i) {
             auto *it = m_phoneList->item(i);
-            if (it->data(Qt::UserRole).toString() == ph &&
-                it->data(Qt::UserRole + 1).toString() == pt)
+            const PhoneNumber listed(
+                it->data(Qt::UserRole).toString().toStdString(),
+                PhoneNumber::stringToType(it->data(Qt::UserRole + 1).toString().toStdString()));
+            if (listed == added)
             {
                 if (!silent) {
                     QMessageBox::information(this, tr("Телефон"),
@@ -277,9 +390,13 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , m_dataFile(QCoreApplication::applicationDirPath() + "/contacts.txt")
+    , m_snapshotFile(QCoreApplication::applicationDirPath() + "/contacts.snap")
+    , m_journalFile(QCoreApplication::applicationDirPath() + "/contacts.journal")
 {
     ui->setupUi(this);
 
+    m_saver = new BackgroundSaver(kSaveDelayMs, this);
+
     qDebug() << "SQL drivers:" << QSqlDatabase::drivers();
 
     QSqlDatabase db = QSqlDatabase::addDatabase("QPSQL", "phonebook_conn");
@@ -309,23 +426,331 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    stopSearch();
+
+    if (m_loadThread)
+    {
+        m_loadCancelled = true;
+        m_loadThread->wait();
+    }
+
+    // отложенные записи выполняем сейчас, пока журнал ещё жив
+    m_saver->flush();
     delete ui;
 }
 
 void MainWindow::loadContactsFromFile()
 {
-    m_book.loadFromFile(m_dataFile.toStdString());
     m_contactDbIds.clear();
+
+    // снимок не старше текстового файла → читаем его, без разбора текста
+    QFileInfo txt(m_dataFile);
+    QFileInfo snap(m_snapshotFile);
+    if (snap.exists() && (!txt.exists() || snap.lastModified() >= txt.lastModified()))
+    {
+        if (m_book.loadSnapshot(m_snapshotFile.toStdString()))
+        {
+            openJournal();
+            return;
+        }
+        qDebug() << "snapshot load failed -> reading text file";
+    }
+
+    // текст читается в фоне, таблица заполняется по мере разбора
+    startStreamingLoad();
+}
+
+void MainWindow::openJournal()
+{
+    // изменения после последнего сохранения contacts.txt
+    if (!m_journal.open(m_journalFile.toStdString(), m_book,
+                        ContactJournal::baseSequence(m_dataFile.toStdString())))
+    {
+        qDebug() << "journal replay failed:" << m_journalFile;
+    }
+}
+
+void MainWindow::setEditingEnabled(bool enabled)
+{
+    ui->btnAdd->setEnabled(enabled);
+    ui->btnEdit->setEnabled(enabled);
+    ui->btnDelete->setEnabled(enabled);
+    ui->btnSort->setEnabled(enabled);
+}
+
+void MainWindow::startStreamingLoad()
+{
+    if (m_loadThread)
+        return;
+
+    m_book.clear();
+    m_loadCancelled = false;
+
+    // пока справочник грузится, индексы строк ещё не окончательные
+    setEditingEnabled(false);
+    statusBar()->showMessage(tr("Загрузка контактов..."));
+
+    auto ok = std::make_shared<bool>(false);
+
+    m_loadThread = QThread::create([this, file = m_dataFile.toStdString(), ok,
+                                    intern = m_book.stringInterning()]()
+    {
+        *ok = ContactBook::streamFromFile(file, kLoadBatchSize,
+                                          [this](std::vector<Contact> &&batch)
+        {
+            if (m_loadCancelled)
+                return false;
+
+            auto shared = std::make_shared<std::vector<Contact>>(std::move(batch));
+            QMetaObject::invokeMethod(this, [this, shared]()
+            {
+                appendLoadedBatch(*shared);
+            }, Qt::QueuedConnection);
+            return true;
+        }, intern);
+    });
+
+    // finished приходит после всех порций: они отправлены из того же потока раньше
+    connect(m_loadThread, &QThread::finished, this, [this, ok]()
+    {
+        m_loadThread->deleteLater();
+        m_loadThread = nullptr;
+        finishStreamingLoad(*ok);
+    });
+
+    m_loadThread->start();
+}
+
+void MainWindow::appendLoadedBatch(std::vector<Contact> &batch)
+{
+    const std::size_t from = m_book.contacts().size();
+    m_book.addContacts(std::move(batch));
+    batch.clear();
+
+    appendTableRows(from);
+    statusBar()->showMessage(tr("Загрузка контактов: %1")
+                                 .arg(static_cast<qulonglong>(m_book.contacts().size())));
+}
+
+void MainWindow::finishStreamingLoad(bool ok)
+{
+    // снимок отражает contacts.txt без журнала
+    if (ok)
+        saveSnapshotInBackground(std::make_shared<const std::vector<Contact>>(m_book.contacts()));
+
+    openJournal();
+
+    for (const auto &st : m_book.stringStats())
+    {
+        qDebug() << "strings" << QString::fromStdString(st.field)
+                 << "values" << static_cast<qulonglong>(st.values)
+                 << "unique" << static_cast<qulonglong>(st.unique)
+                 << "saved KB" << static_cast<qulonglong>(st.savedBytes() / 1024);
+    }
+
+    setEditingEnabled(true);
+    statusBar()->clearMessage();
+    refreshTable(m_lastFilter);
+}
+
+void MainWindow::startImport(const QString &fileName, ImportFormat format)
+{
+    // порции дописываются к таблице, отфильтрованной по m_lastFilter
+    if (stopSearch())
+        refreshTable(searchText());
+
+    m_loadCancelled = false;
+    setEditingEnabled(false);
+    ui->btnImport->setEnabled(false);
+    statusBar()->showMessage(tr("Импорт контактов..."));
+
+    auto result = std::make_shared<ImportResult>();
+    auto inFlight = std::make_shared<QSemaphore>(kImportBatchesInFlight);
+    const QString reportFile = fileName + ".rejected.txt";
+    QFile::remove(reportFile);
+
+    m_loadThread = QThread::create([this, file = fileName.toStdString(), format, reportFile, result,
+                                    inFlight, toDb = m_useDb]()
+    {
+        // отклонённые строки сразу уходят в отчёт, в памяти — только первые несколько
+        QFile report(reportFile);
+
+        // соединение с БД принадлежит потоку, который его открыл, — у импорта своё
+        const QString dbName = "phonebook_import";
+        {
+            QSqlDatabase db;
+            if (toDb)
+            {
+                db = QSqlDatabase::cloneDatabase("phonebook_conn", dbName);
+                if (!db.open())
+                {
+                    qDebug() << "import DB open failed:" << db.lastError().text();
+                    db = QSqlDatabase();
+                    QSqlDatabase::removeDatabase(dbName);
+                    return;
+                }
+            }
+            std::size_t saved = 0;
+
+            result->ok = ContactImporter::importFile(file, format,
+                                                     [this, result, inFlight, toDb, &db, &saved](std::vector<Contact> &&batch)
+            {
+                if (m_loadCancelled)
+                    return false;
+
+                // в режиме БД порция пишется здесь же, окну — только счётчик
+                if (toDb)
+                {
+                    const std::size_t failed = insertBatchToDb(db, batch);
+                    result->notSaved += failed;
+                    saved += batch.size() - failed;
+                    QMetaObject::invokeMethod(this, [this, saved]()
+                    {
+                        statusBar()->showMessage(tr("Импорт контактов: %1")
+                                                     .arg(static_cast<qulonglong>(saved)));
+                    }, Qt::QueuedConnection);
+                    return true;
+                }
+
+                // окно не успевает — ждём; отмену проверяем, пока ждём
+                while (!inFlight->tryAcquire(1, 100))
+                {
+                    if (m_loadCancelled)
+                        return false;
+                }
+
+                auto shared = std::make_shared<std::vector<Contact>>(std::move(batch));
+                QMetaObject::invokeMethod(this, [this, shared, inFlight]()
+                {
+                    appendImportedBatch(*shared);
+                    inFlight->release();
+                }, Qt::QueuedConnection);
+                return true;
+            },
+                                                     [&report, result](const ContactImporter::Rejection &r)
+            {
+                const QString line = MainWindow::tr("строка %1: %2")
+                                         .arg(static_cast<qulonglong>(r.line))
+                                         .arg(QString::fromStdString(r.reason));
+                if (result->samples.size() < kImportSampleRejections)
+                    result->samples << line;
+
+                if (report.isOpen() || report.open(QIODevice::WriteOnly))
+                    report.write((line + "\n").toUtf8());
+            },
+                                                     &result->stats);
+        }
+        if (toDb)
+            QSqlDatabase::removeDatabase(dbName);
+    });
+
+    connect(m_loadThread, &QThread::finished, this, [this, result, reportFile]()
+    {
+        m_loadThread->deleteLater();
+        m_loadThread = nullptr;
+
+        if (m_useDb)
+            loadContactsFromDb();
+        else if (result->stats.accepted > 0)
+            saveContactsToFile();
+
+        setEditingEnabled(true);
+        ui->btnImport->setEnabled(true);
+        statusBar()->clearMessage();
+        refreshTable(m_lastFilter);
+
+        QString msg = tr("Импортировано: %1\nОтклонено: %2")
+                          .arg(static_cast<qulonglong>(result->stats.accepted - result->notSaved))
+                          .arg(static_cast<qulonglong>(result->stats.rejected));
+        if (result->notSaved > 0)
+            msg += tr("\nНе записано в БД: %1").arg(static_cast<qulonglong>(result->notSaved));
+        if (!result->samples.isEmpty())
+            msg += "\n\n" + result->samples.join("\n")
+                 + tr("\n\nВсе отклонённые строки: %1").arg(reportFile);
+
+        if (result->ok)
+            QMessageBox::information(this, tr("Импорт"), msg);
+        else
+            QMessageBox::warning(this, tr("Импорт"), tr("Файл прочитан не полностью.\n") + msg);
+    });
+
+    m_loadThread->start();
+}
+
+void MainWindow::appendImportedBatch(std::vector<Contact> &batch)
+{
+    const std::size_t from = m_book.contacts().size();
+    m_book.addContacts(std::move(batch));
+    batch.clear();
+
+    appendTableRows(from);
+    statusBar()->showMessage(tr("Импорт контактов: %1")
+                                 .arg(static_cast<qulonglong>(m_book.contacts().size())));
 }
 
 void MainWindow::saveContactsToFile()
 {
-    if (!m_book.saveToFile(m_dataFile.toStdString()))
+    // неизменяемый снимок на момент вызова; пишется в фоне, серия вызовов — одной записью
+    auto contacts = std::make_shared<const std::vector<Contact>>(m_book.contacts());
+    m_journal.commitPendingSort(); // сортировка уже в снимке
+    const std::uint64_t seq = m_journal.lastSequence();
+    const std::string base = m_dataFile.toStdString();
+
+    m_saver->schedule(base, contacts,
+                      [base, seq](const std::vector<Contact> &list)
+    {
+        return ContactJournal::writeBase(list, base, seq);
+    },
+                      [this, seq, contacts](bool ok)
+    {
+        baseFileSaved(ok, seq, contacts);
+    });
+}
+
+void MainWindow::baseFileSaved(bool ok, std::uint64_t seq, BackgroundSaver::Contacts contacts)
+{
+    if (!ok)
     {
         QMessageBox::warning(this,
                              tr("Ошибка"),
                              tr("Не удалось сохранить файл контактов:\n%1")
                                  .arg(m_dataFile));
+        return;
+    }
+
+    // эти записи журнала уже в contacts.txt
+    m_journal.dropUpTo(seq);
+
+    // снимок должен совпадать с contacts.txt: старый удаляем,
+    // новый пишем, только если следом не идёт ещё одна запись файла
+    QFile::remove(m_snapshotFile);
+    if (!m_saver->hasPending(m_dataFile.toStdString()))
+        saveSnapshotInBackground(std::move(contacts));
+}
+
+void MainWindow::saveSnapshotInBackground(BackgroundSaver::Contacts contacts)
+{
+    const std::string snap = m_snapshotFile.toStdString();
+    m_saver->schedule(snap, std::move(contacts), [snap](const std::vector<Contact> &list)
+    {
+        return ContactSnapshot::save(list, snap);
+    });
+}
+
+void MainWindow::journalAppended(bool ok)
+{
+    if (!ok)
+    {
+        // журнал недоступен — сохраняем справочник целиком
+        saveContactsToFile();
+        return;
+    }
+
+    // журнал разросся — сворачиваем его в contacts.txt (если это ещё не запланировано)
+    if (m_journal.size() >= kJournalCompactSize
+        && !m_saver->hasPending(m_dataFile.toStdString()))
+    {
+        saveContactsToFile();
     }
 }
 
@@ -391,6 +816,8 @@ bool MainWindow::importFromFileToDbIfEmpty()
 
     ContactBook tmp;
     tmp.loadFromFile(m_dataFile.toStdString());
+    ContactJournal::replay(m_journalFile.toStdString(), tmp,
+                           ContactJournal::baseSequence(m_dataFile.toStdString()));
     const auto &list = tmp.contacts();
 
     if (list.empty()) {
@@ -416,7 +843,7 @@ bool MainWindow::loadContactsFromDb()
     QSqlDatabase db = dbConn();
     if (!db.isOpen()) return false;
 
-    m_book = ContactBook{};
+    m_book.clear();
     m_contactDbIds.clear();
 
     QSqlQuery qc(db);
@@ -442,7 +869,7 @@ bool MainWindow::loadContactsFromDb()
 
         Date d = Date::fromString(bd);
         if (!d.isValid()) {
-            d = Date::fromString("2000-01-01");
+            d = Date(2000, 1, 1);
         }
 
         Contact c(ln, fn, mn, adr, d, em);
@@ -468,8 +895,7 @@ bool MainWindow::loadContactsFromDb()
             c.addPhone(PhoneNumber(num, t));
         }
 
-        m_book.addContact(c);
-        m_contactDbIds.push_back(id);
+        m_contactDbIds[m_book.addContact(std::move(c))] = id;
     }
 
     return true;
@@ -515,7 +941,7 @@ bool MainWindow::insertContactToDb(const Contact &c)
             VALUES(:cid, :num, :typ);
         )");
         qp.bindValue(":cid", newId);
-        qp.bindValue(":num", QString::fromStdString(ph.number()));
+        qp.bindValue(":num", phoneText(ph));
         qp.bindValue(":typ", QString::fromStdString(PhoneNumber::typeToString(ph.type())));
 
         if (!qp.exec()) {
@@ -579,7 +1005,7 @@ bool MainWindow::updateContactInDb(int contactId, const Contact &c)
             VALUES(:cid, :num, :typ);
         )");
         qp.bindValue(":cid", contactId);
-        qp.bindValue(":num", QString::fromStdString(ph.number()));
+        qp.bindValue(":num", phoneText(ph));
         qp.bindValue(":typ", QString::fromStdString(PhoneNumber::typeToString(ph.type())));
         if (!qp.exec()) {
             qDebug() << "insert phone failed:" << qp.lastError().text();
@@ -623,84 +1049,99 @@ void MainWindow::loadContacts()
     }
 }
 
-void MainWindow::saveContacts()
-{
-    if (!m_useDb) {
-        saveContactsToFile();
-    }
-}
-
-void MainWindow::refreshTable(const QString &filter)
+void MainWindow::fillTableRow(int row, ContactHandle h)
 {
-    const auto &list = m_book.contacts();
-
-    m_rowToIndex.clear();
-    m_lastFilter = filter;
-
-    const QString f = filter.toLower();
+    const Contact *contact = m_book.contact(h);
+    if (!contact)
+        return;
+    const Contact &c = *contact;
 
-    for (std::size_t i = 0; i < list.size(); ++i)
+    auto setCell = [&](int col, const std::string &text, bool storeId = false)
     {
-        const Contact &c = list[i];
+        auto *item = new QTableWidgetItem(QString::fromStdString(text));
 
-        QString all = QString::fromStdString(
-            c.lastName()  + " " +
-            c.firstName() + " " +
-            c.middleName() + " " +
-            c.address()   + " " +
-            c.email()
-            );
+        if (storeId && m_useDb) {
+            auto it = m_contactDbIds.find(h);
+            if (it != m_contactDbIds.end())
+                item->setData(Qt::UserRole, it->second);
+        }
 
-        const auto &phones = c.phones();
-        for (const auto &ph : phones)
-            all += " " + QString::fromStdString(ph.number());
+        ui->tableContacts->setItem(row, col, item);
+    };
 
-        if (!f.isEmpty() && !all.toLower().contains(f))
-            continue;
+    setCell(0, c.lastName(), true);
+    setCell(1, c.firstName());
+    setCell(2, c.middleName());
+    setCell(3, c.address());
+    setCell(4, c.birthDate().toString());
+    setCell(5, c.email());
 
-        m_rowToIndex.push_back(i);
+    QString phonesStr;
+    const auto &phones = c.phones();
+    for (std::size_t i = 0; i < phones.size(); ++i)
+    {
+        if (i != 0)
+            phonesStr += "; ";
+        phonesStr += phoneText(phones[i]);
     }
 
+    auto *phonesItem = new QTableWidgetItem(phonesStr);
+    ui->tableContacts->setItem(row, 6, phonesItem);
+}
+
+void MainWindow::refreshTable(const QString &filter)
+{
+    m_rowToHandle.clear();
+    m_lastFilter = filter;
+    appendFilteredRows(0);
+
     ui->tableContacts->clearContents();
-    ui->tableContacts->setRowCount(static_cast<int>(m_rowToIndex.size()));
+    ui->tableContacts->setRowCount(static_cast<int>(m_rowToHandle.size()));
 
-    for (int row = 0; row < static_cast<int>(m_rowToIndex.size()); ++row)
-    {
-        std::size_t idx = m_rowToIndex[static_cast<std::size_t>(row)];
-        const Contact &c = list[idx];
+    for (int row = 0; row < static_cast<int>(m_rowToHandle.size()); ++row)
+        fillTableRow(row, m_rowToHandle[static_cast<std::size_t>(row)]);
 
-        auto setCell = [&](int col, const std::string &text, bool storeId = false)
-        {
-            auto *item = new QTableWidgetItem(QString::fromStdString(text));
+    ui->tableContacts->resizeColumnsToContents();
+}
 
-            if (storeId && m_useDb && idx < m_contactDbIds.size()) {
-                item->setData(Qt::UserRole, m_contactDbIds[idx]);
-            }
+void MainWindow::appendFilteredRows(std::size_t from)
+{
+    // фоновый поиск работает с m_search и справочником — таблица считается здесь
+    stopSearch();
 
-            ui->tableContacts->setItem(row, col, item);
-        };
+    if (m_lastFilter.isEmpty())
+    {
+        for (std::size_t i = from; i < m_book.contacts().size(); ++i)
+            m_rowToHandle.push_back(m_book.handleAt(i));
+        return;
+    }
 
-        setCell(0, c.lastName(), true);
-        setCell(1, c.firstName());
-        setCell(2, c.middleName());
-        setCell(3, c.address());
-        setCell(4, c.birthDate().toString());
-        setCell(5, c.email());
+    // «last:Иванов born:1980..1990» — запрос по полям; не разобрался — обычный поиск
+    const std::string filter = m_lastFilter.toStdString();
+    ContactQuery query;
+    std::vector<std::size_t> queried;
+    const bool structured = ContactQuery::isStructured(filter) && ContactQuery::parse(filter, query);
+    if (structured)
+        queried = m_book.findQuery(query);
+
+    // тот же поиск, что и ContactBook::find; при вводе по буквам сужается прежний результат
+    const std::vector<std::size_t> &found = structured ? queried : m_search.search(filter);
+    for (auto it = std::lower_bound(found.begin(), found.end(), from); it != found.end(); ++it)
+        m_rowToHandle.push_back(m_book.handleAt(*it));
+}
 
-        QString phonesStr;
-        const auto &phones = c.phones();
-        for (std::size_t i = 0; i < phones.size(); ++i)
-        {
-            if (i != 0)
-                phonesStr += "; ";
-            phonesStr += QString::fromStdString(phones[i].number());
-        }
+void MainWindow::appendTableRows(std::size_t from)
+{
+    const std::size_t firstRow = m_rowToHandle.size();
+    appendFilteredRows(from);
 
-        auto *phonesItem = new QTableWidgetItem(phonesStr);
-        ui->tableContacts->setItem(row, 6, phonesItem);
-    }
+    ui->tableContacts->setRowCount(static_cast<int>(m_rowToHandle.size()));
+    for (std::size_t row = firstRow; row < m_rowToHandle.size(); ++row)
+        fillTableRow(static_cast<int>(row), m_rowToHandle[row]);
 
-    ui->tableContacts->resizeColumnsToContents();
+    // ширину колонок подбираем по первой порции, дальше — в конце загрузки
+    if (firstRow == 0)
+        ui->tableContacts->resizeColumnsToContents();
 }
 
 //  СЛОТЫ КНОПОК
@@ -712,6 +1153,9 @@ void MainWindow::on_btnAdd_clicked()
     {
         Contact c = dlg.contact();
 
+        // фоновый поиск читает справочник; таблицу после изменения строим заново
+        stopSearch();
+
         if (m_useDb) {
             if (!insertContactToDb(c)) {
                 QMessageBox::warning(this, tr("DB"),
@@ -719,13 +1163,13 @@ void MainWindow::on_btnAdd_clicked()
                 return;
             }
             loadContacts();
-            refreshTable(m_lastFilter);
+            refreshTable(searchText());
             return;
         }
 
-        m_book.addContact(c);
-        saveContacts();
-        refreshTable(m_lastFilter);
+        const ContactHandle h = m_book.addContact(std::move(c));
+        journalAppended(m_journal.appendAdd(*m_book.contact(h)));
+        refreshTable(searchText());
     }
 }
 
@@ -738,24 +1182,26 @@ void MainWindow::on_btnEdit_clicked()
                              tr("Сначала выберите контакт в таблице."));
         return;
     }
-    if (row >= static_cast<int>(m_rowToIndex.size()))
+    if (row >= static_cast<int>(m_rowToHandle.size()))
         return;
 
-    std::size_t idx = m_rowToIndex[static_cast<std::size_t>(row)];
-    const auto &list = m_book.contacts();
-    if (idx >= list.size())
+    const ContactHandle h = m_rowToHandle[static_cast<std::size_t>(row)];
+    const Contact *current = m_book.contact(h);
+    if (!current)
         return;
 
     ContactDialog dlg(this);
-    dlg.setContact(list[idx]);
+    dlg.setContact(*current);
 
     if (dlg.exec() == QDialog::Accepted)
     {
         Contact c = dlg.contact();
+        stopSearch();
 
         if (m_useDb) {
-            QTableWidgetItem *first = ui->tableContacts->item(row, 0);
-            int contactId = first ? first->data(Qt::UserRole).toInt() : -1;
+            // пока открыт диалог, таблицу мог перестроить фоновый поиск — id по handle
+            const auto id = m_contactDbIds.find(h);
+            int contactId = id != m_contactDbIds.end() ? id->second : -1;
             if (contactId <= 0) {
                 QMessageBox::warning(this, tr("DB"), tr("Не найден contact_id."));
                 return;
@@ -768,13 +1214,16 @@ void MainWindow::on_btnEdit_clicked()
             }
 
             loadContacts();
-            refreshTable(m_lastFilter);
+            refreshTable(searchText());
             return;
         }
 
-        m_book.updateContact(idx, c);
-        saveContacts();
-        refreshTable(m_lastFilter);
+        // журнал хранит позицию контакта — берём её на момент изменения
+        const std::size_t idx = m_book.indexOf(h);
+        if (!m_book.updateContact(h, std::move(c)))
+            return;
+        journalAppended(m_journal.appendUpdate(idx, *m_book.contact(h)));
+        refreshTable(searchText());
     }
 }
 
@@ -787,9 +1236,12 @@ void MainWindow::on_btnDelete_clicked()
                              tr("Сначала выберите контакт в таблице."));
         return;
     }
-    if (row >= static_cast<int>(m_rowToIndex.size()))
+    if (row >= static_cast<int>(m_rowToHandle.size()))
         return;
 
+    // до вопроса: пока он открыт, таблицу может перестроить фоновый поиск
+    const ContactHandle h = m_rowToHandle[static_cast<std::size_t>(row)];
+
     if (QMessageBox::question(this, tr("Удаление"),
                               tr("Удалить выбранный контакт?"),
                               QMessageBox::Yes | QMessageBox::No,
@@ -799,11 +1251,11 @@ void MainWindow::on_btnDelete_clicked()
         return;
     }
 
-    std::size_t idx = m_rowToIndex[static_cast<std::size_t>(row)];
+    stopSearch();
 
     if (m_useDb) {
-        QTableWidgetItem *first = ui->tableContacts->item(row, 0);
-        int contactId = first ? first->data(Qt::UserRole).toInt() : -1;
+        const auto id = m_contactDbIds.find(h);
+        int contactId = id != m_contactDbIds.end() ? id->second : -1;
         if (contactId <= 0) {
             QMessageBox::warning(this, tr("DB"), tr("Не найден contact_id."));
             return;
@@ -816,35 +1268,101 @@ void MainWindow::on_btnDelete_clicked()
         }
 
         loadContacts();
-        refreshTable(m_lastFilter);
+        refreshTable(searchText());
         return;
     }
 
-    m_book.removeContact(idx);
-    saveContacts();
-    refreshTable(m_lastFilter);
+    const std::size_t idx = m_book.indexOf(h);
+    if (!m_book.removeContact(h))
+        return;
+    journalAppended(m_journal.appendRemove(idx));
+    refreshTable(searchText());
 }
 
 //  ПОИСК
 void MainWindow::on_btnSearch_clicked()
 {
-    bool ok = false;
-    QString text = QInputDialog::getText(
-        this,
-        tr("Поиск"),
-        tr("Введите строку для поиска\n"
-           "(ФИО, адрес, e-mail или телефон):"),
-        QLineEdit::Normal,
-        m_lastFilter,
-        &ok
-        );
+    // поиск идёт по мере ввода в строке поиска
+    ui->editSearch->setFocus();
+    ui->editSearch->selectAll();
+}
 
-    if (!ok)
+void MainWindow::on_editSearch_textChanged(const QString &text)
+{
+    // прежний запрос устарел
+    stopSearch();
+
+    const QString filter = text.trimmed();
+    const std::string query = filter.toStdString();
+
+    // сужение прежнего результата и запрос по полям быстрые — сразу;
+    // пока справочник грузится, он меняется, и поиск тоже идёт сразу
+    if (filter.isEmpty() || m_loadThread || ContactQuery::isStructured(query)
+        || !m_search.needsFullSearch(query))
+    {
+        refreshTable(filter);
+        return;
+    }
+
+    startSearch(filter);
+}
+
+void MainWindow::startSearch(const QString &filter)
+{
+    // m_lastFilter меняет только refreshTable: до конца поиска
+    // таблица и m_lastFilter остаются от прежнего запроса
+    m_searchFilter = filter;
+    m_searchCancelled = false;
+
+    auto found = std::make_shared<bool>(false);
+    QThread *thread = QThread::create([this, query = filter.toStdString(), found]()
+    {
+        *found = m_search.search(query, m_searchCancelled) != nullptr;
+    });
+    m_searchThread = thread;
+
+    connect(thread, &QThread::finished, this, [this, thread, found]()
+    {
+        thread->deleteLater();
+        // поиск отменён или снят stopSearch — таблицей занимается тот, кто его снял
+        if (m_searchThread != thread)
+            return;
+        m_searchThread = nullptr;
+
+        if (*found)
+            refreshTable(m_searchFilter); // результат уже в стопке m_search
+    });
+
+    thread->start();
+}
+
+bool MainWindow::stopSearch()
+{
+    if (!m_searchThread)
+        return false;
+
+    // просмотр и перестройка индекса проверяют отмену часто — ждать недолго
+    m_searchCancelled = true;
+    m_searchThread->wait();
+    m_searchThread = nullptr;
+    return true;
+}
+
+void MainWindow::finishSearch()
+{
+    if (!m_searchThread)
         return;
 
-    text = text.trimmed();
-    refreshTable(text);
+    m_searchThread->wait();
+    m_searchThread = nullptr;
+    refreshTable(m_searchFilter);
+}
+
+QString MainWindow::searchText() const
+{
+    return ui->editSearch->text().trimmed();
 }
+
 //  СОРТИРОВКА
 void MainWindow::on_btnSort_clicked()
 {
@@ -887,6 +1405,91 @@ void MainWindow::on_btnSort_clicked()
     if (fieldStr.startsWith(tr("Дата")))
         field = SortField::BirthDate;
 
+    stopSearch();
     m_book.sortBy(field, asc);
-    refreshTable(m_lastFilter);
+    if (!m_useDb)
+        m_journal.setPendingSort(field, asc);
+    refreshTable(searchText());
+}
+
+void MainWindow::on_btnImport_clicked()
+{
+    if (m_loadThread)
+        return;
+
+    const QString fileName = QFileDialog::getOpenFileName(
+        this,
+        tr("Импорт контактов"),
+        QString(),
+        tr("Контакты (*.csv *.vcf *.vcard);;CSV (*.csv);;vCard (*.vcf *.vcard)")
+        );
+
+    if (fileName.isEmpty())
+        return;
+
+    ImportFormat format;
+    if (!ContactImporter::formatFromFileName(fileName.toStdString(), format))
+    {
+        QMessageBox::warning(this, tr("Импорт"),
+                             tr("Неизвестный формат файла:\n%1").arg(fileName));
+        return;
+    }
+
+    startImport(fileName, format);
+}
+
+void MainWindow::on_btnExport_clicked()
+{
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(
+        this,
+        tr("Экспорт контактов"),
+        QString(),
+        tr("CSV (*.csv);;vCard (*.vcf);;JSON Lines (*.jsonl)"),
+        &selectedFilter
+        );
+
+    if (fileName.isEmpty())
+        return;
+
+    // расширение не указано — берём его из выбранного фильтра
+    ExportFormat format;
+    if (!ContactExporter::formatFromFileName(fileName.toStdString(), format))
+    {
+        if (selectedFilter.startsWith("vCard"))
+            fileName += ".vcf";
+        else if (selectedFilter.startsWith("JSON"))
+            fileName += ".jsonl";
+        else
+            fileName += ".csv";
+        ContactExporter::formatFromFileName(fileName.toStdString(), format);
+    }
+
+    // при активном фильтре выгружаются только найденные контакты —
+    // по запросу, набранному в строке поиска, даже если он ещё ищется
+    finishSearch();
+    std::vector<std::size_t> filtered;
+    const std::vector<std::size_t> *rows = nullptr;
+    if (!m_lastFilter.isEmpty())
+    {
+        filtered.reserve(m_rowToHandle.size());
+        for (ContactHandle h : m_rowToHandle)
+        {
+            const std::size_t idx = m_book.indexOf(h);
+            if (idx != SlotMap<Contact>::npos)
+                filtered.push_back(idx);
+        }
+        rows = &filtered;
+    }
+    const std::size_t count = rows ? rows->size() : m_book.contacts().size();
+
+    if (!m_book.exportToFile(fileName.toStdString(), format, rows))
+    {
+        QMessageBox::warning(this, tr("Экспорт"),
+                             tr("Не удалось записать файл:\n%1").arg(fileName));
+        return;
+    }
+
+    statusBar()->showMessage(tr("Экспортировано контактов: %1")
+                                 .arg(static_cast<qulonglong>(count)), 5000);
 }
@@ -2,13 +2,20 @@
 
 #include <QMainWindow>
 #include <QString>
+#include <atomic>
+#include <unordered_map>
 #include <vector>
 
+#include "BackgroundSaver.h"
 #include "ContactBook.h"
+#include "ContactImporter.h"
+#include "ContactJournal.h"
+#include "IncrementalSearch.h"
 #include "Validator.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
+class QThread;
 QT_END_NAMESPACE
 
 class MainWindow : public QMainWindow
@@ -26,15 +33,40 @@ private:
 
     ContactBook m_book;
     QString     m_dataFile;
+    QString     m_snapshotFile;
+    QString     m_journalFile;
+
+    ContactJournal   m_journal;
+    BackgroundSaver* m_saver = nullptr;
+
+    QThread*          m_loadThread = nullptr;
+    std::atomic<bool> m_loadCancelled{false};
 
     bool m_useDb = false;
-    std::vector<int> m_contactDbIds;
+    std::unordered_map<ContactHandle, int> m_contactDbIds;
 
     QString m_lastFilter;
-    std::vector<std::size_t> m_rowToIndex;
+    // строки таблицы → контакты; handle не устаревают при удалении других контактов
+    std::vector<ContactHandle> m_rowToHandle;
+    IncrementalSearch m_search{m_book};
+
+    // поиск по всему справочнику идёт в фоне; следующая буква его отменяет
+    QThread*          m_searchThread = nullptr;
+    std::atomic<bool> m_searchCancelled{false};
+    QString           m_searchFilter;     // запрос, который ищется в фоне
 
     void loadContactsFromFile();
+    void openJournal();
+    void startStreamingLoad();
+    void appendLoadedBatch(std::vector<Contact> &batch);
+    void finishStreamingLoad(bool ok);
+    void setEditingEnabled(bool enabled);
+    void startImport(const QString &fileName, ImportFormat format);
+    void appendImportedBatch(std::vector<Contact> &batch);
     void saveContactsToFile();
+    void baseFileSaved(bool ok, std::uint64_t seq, BackgroundSaver::Contacts contacts);
+    void saveSnapshotInBackground(BackgroundSaver::Contacts contacts);
+    void journalAppended(bool ok);
 
     bool ensureDbSchema();
     bool loadContactsFromDb();
@@ -43,13 +75,22 @@ private:
     bool deleteContactFromDb(int contactId);
 
     void loadContacts();
-    void saveContacts();
     void refreshTable(const QString &filter = QString());
+    void appendTableRows(std::size_t from);
+    void fillTableRow(int row, ContactHandle h);
+    void appendFilteredRows(std::size_t from);
+    void startSearch(const QString &filter);
+    bool stopSearch();
+    void finishSearch();
+    QString searchText() const;
 
 private slots:
     void on_btnAdd_clicked();
     void on_btnEdit_clicked();
     void on_btnDelete_clicked();
     void on_btnSearch_clicked();
+    void on_editSearch_textChanged(const QString &text);
     void on_btnSort_clicked();
+    void on_btnImport_clicked();
+    void on_btnExport_clicked();
 };
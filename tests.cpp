@@ -1,3 +1,6 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -7,6 +10,14 @@
 #include "ContactBook.h"
 #include "Contact.h"
 #include "PhoneNumber.h"
+#include "ContactBlockStore.h"
+#include "ContactImporter.h"
+#include "ContactJournal.h"
+#include "ContactQuery.h"
+#include "IncrementalSearch.h"
+#include "SearchKey.h"
+#include "SubstringScan.h"
+#include "Translit.h"
 
 void printResult(const std::string& what, bool got, bool expected)
 {
@@ -129,6 +140,34 @@ void testDates()
         std::cout << "[Date] " << c.label << " ";
         printResult("", got, c.ok);
     }
+
+    // «сегодня» передано явно (импорт берёт его один раз): строго раньше него
+    printResult("[Date] born today", Validator::isValidBirthDate(Date(2020, 5, 10), Date(2020, 5, 10)), false);
+    printResult("[Date] born yesterday", Validator::isValidBirthDate(Date(2020, 5, 10), Date(2020, 5, 11)), true);
+    printResult("[Date] today is valid", Validator::today().isValid(), true);
+}
+
+void testDateFormat()
+{
+    std::cout << "\n=== TEST DATE FORMAT ===\n";
+
+    const Date d = Date::fromString("1987-06-05");
+    printResult("parse fields", d.year() == 1987 && d.month() == 6 && d.day() == 5, true);
+    printResult("format iso", d.toString() == "1987-06-05", true);
+    printResult("lenient parse", Date::fromString("1987-6-5") == d, true);
+    printResult("garbage -> empty", Date::fromString("вчера") == Date(), true);
+    printResult("field out of range -> invalid", Date(2000, 20, 1).isValid(), false);
+    printResult("order by packed value",
+                Date(1999, 12, 31) < Date(2000, 1, 1) && Date(2000, 1, 2) > Date(2000, 1, 1), true);
+    printResult("packed round trip", Date::fromPacked(d.packed()) == d, true);
+
+    const std::string_view texts[] = { "2001-02-03", "1990-1-1", "нет" };
+    Date dates[3];
+    const std::size_t fast = Date::parseIso(texts, 3, dates);
+    char out[3 * Date::kIsoLength];
+    Date::formatIso(dates, 3, out);
+    printResult("column parse / format",
+                fast == 1 && std::string(out, sizeof(out)) == "2001-02-031990-01-010000-00-00", true);
 }
 
 // --- Тест ContactBook (save/load round-trip) -----------------------
@@ -174,13 +213,1183 @@ void testContactBookRoundTrip()
     }
 }
 
+// --- Тест двоичного снимка (save/load round-trip) ------------------
+
+void testSnapshotRoundTrip()
+{
+    std::cout << "\n=== TEST SNAPSHOT SAVE/LOAD ===\n";
+
+    const std::string fileName = "test_contacts.snap";
+
+    Contact c("Иванов", "Пётр", "Николаевич", "Москва",
+              Date::fromString("2000-01-01"), "test@mail.ru");
+    c.addPhone(PhoneNumber("+79990001122", PhoneType::Mobile));
+    c.addPhone(PhoneNumber("8(812)1234567", PhoneType::Work));
+
+    ContactBook book1;
+    book1.addContact(c);
+    book1.addContact(c); // повторяющиеся строки попадут в пул один раз
+
+    printResult("saveSnapshot", book1.saveSnapshot(fileName), true);
+
+    ContactBook book2;
+    printResult("loadSnapshot", book2.loadSnapshot(fileName), true);
+
+    const auto &list = book2.contacts();
+    printResult("loaded size == 2", list.size() == 2, true);
+
+    if (!list.empty())
+    {
+        const Contact &c2 = list[1];
+        printResult("middleName equal", c2.middleName() == c.middleName(), true);
+        printResult("birthDate equal",
+                    c2.birthDate().toString() == c.birthDate().toString(), true);
+        printResult("phones size eq", c2.phones().size() == 2, true);
+        printResult("phone type eq",
+                    c2.phones().size() == 2 && c2.phones()[1].type() == PhoneType::Work, true);
+    }
+}
+
+// --- Тест журнала изменений (запись, повтор, сжатие) ----------------
+
+void testJournalReplay()
+{
+    std::cout << "\n=== TEST JOURNAL REPLAY ===\n";
+
+    const std::string baseName    = "test_journal_base.txt";
+    const std::string journalName = "test_journal.journal";
+    std::remove(journalName.c_str());
+
+    Contact a("Иванов", "Пётр", "", "Москва", Date::fromString("2000-01-01"), "a@mail.ru");
+    Contact b("Петров", "Иван", "", "Казань", Date::fromString("1990-05-05"), "b@mail.ru");
+    b.addPhone(PhoneNumber("+79990001122", PhoneType::Home));
+
+    std::vector<Contact> base{a};
+    printResult("writeBase", ContactJournal::writeBase(base, baseName, 0), true);
+
+    {
+        ContactBook book;
+        book.loadFromFile(baseName);
+        ContactJournal journal;
+        journal.open(journalName, book, ContactJournal::baseSequence(baseName));
+
+        book.addContact(b);
+        journal.appendAdd(b);
+        book.sortBy(SortField::BirthDate, true);
+        journal.setPendingSort(SortField::BirthDate, true);
+        book.removeContact(1);
+        printResult("append remove", journal.appendRemove(1), true);
+    }
+
+    ContactBook book2;
+    book2.loadFromFile(baseName);
+    ContactJournal journal2;
+    journal2.open(journalName, book2, ContactJournal::baseSequence(baseName));
+
+    const auto &list = book2.contacts();
+    printResult("replayed size == 1", list.size() == 1, true);
+    printResult("replayed contact",
+                !list.empty() && list[0].lastName() == "Петров"
+                    && list[0].phones().size() == 1, true);
+
+    // сжатие: записи журнала переезжают в основной файл
+    const std::uint64_t seq = journal2.lastSequence();
+    printResult("compact base", ContactJournal::writeBase(list, baseName, seq), true);
+    printResult("drop journal", journal2.dropUpTo(seq), true);
+    printResult("journal empty", journal2.size() == 0, true);
+
+    ContactBook book3;
+    book3.loadFromFile(baseName);
+    ContactJournal::replay(journalName, book3, ContactJournal::baseSequence(baseName));
+    printResult("after compact size == 1", book3.contacts().size() == 1, true);
+
+    // сортировка, потом импорт и запись основного файла: сортировка уже в нём
+    // и не должна переставить дописанные контакты при загрузке
+    {
+        Contact c("Сидоров", "Олег", "", "", Date::fromString("1980-01-01"), "");
+        Contact d("Алексеев", "Олег", "", "", Date::fromString("1970-01-01"), "");
+        book3.addContact(b);
+        journal2.appendAdd(b);
+        book3.sortBy(SortField::LastName, true);
+        journal2.setPendingSort(SortField::LastName, true);
+        book3.addContacts(std::vector<Contact>{ c, d }); // импорт — в конец, без журнала
+        journal2.commitPendingSort();
+        const std::uint64_t importSeq = journal2.lastSequence();
+        ContactJournal::writeBase(book3.contacts(), baseName, importSeq);
+        journal2.dropUpTo(importSeq);
+
+        Contact e = book3.contacts()[2];
+        e.setEmail("changed@mail.ru");
+        book3.updateContact(2, e);
+        journal2.appendUpdate(2, e);
+    }
+
+    ContactBook book4;
+    book4.loadFromFile(baseName);
+    ContactJournal::replay(journalName, book4, ContactJournal::baseSequence(baseName));
+    bool same = book4.contacts().size() == book3.contacts().size();
+    for (std::size_t i = 0; same && i < book4.contacts().size(); ++i)
+        same = book4.contacts()[i].lastName() == book3.contacts()[i].lastName()
+            && book4.contacts()[i].email() == book3.contacts()[i].email();
+    printResult("sort before import replays", same, true);
+}
+
+void testBlockStore()
+{
+    std::cout << "\n=== TEST BLOCK STORE ===\n";
+
+    const std::string fileName = "test_blocks.pbb";
+
+    ContactBook book;
+    for (int i = 0; i < 300; ++i)
+    {
+        const std::string last = i % 3 == 0 ? "Сидоров" : "Фамилия" + std::to_string(i);
+        Contact c(last, "Иван", "Петрович", "Москва, ул. Ленина, д. " + std::to_string(i),
+                  Date::fromString("1985-03-15"), "user" + std::to_string(i) + "@mail.ru");
+        c.addPhone(PhoneNumber("+7999000" + std::to_string(1000 + i), PhoneType::Mobile));
+        book.addContact(c);
+    }
+
+    // маленькие блоки, чтобы их было несколько
+    printResult("save blocks", ContactBlockStore::save(book.contacts(), fileName, 2048), true);
+
+    ContactBlockStore store;
+    printResult("open", store.open(fileName), true);
+    printResult("several blocks", store.blocks().size() > 1, true);
+
+    ContactBook all;
+    printResult("load all", all.loadFromBlockFile(fileName), true);
+    printResult("all size == 300", all.contacts().size() == 300, true);
+
+    ContactBook some;
+    printResult("load by last name", some.loadFromBlockFile(fileName, "Сидоров"), true);
+    printResult("found 100", some.contacts().size() == 100, true);
+    printResult("phones kept",
+                !some.contacts().empty() && some.contacts()[0].phones().size() == 1, true);
+
+    ContactBook none;
+    none.loadFromBlockFile(fileName, "Нет такой");
+    printResult("missing last name", none.contacts().empty(), true);
+
+    // повреждённый индекс: open() отказывает, а не выделяет память по rawSize
+    std::string bytes;
+    if (FILE* f = std::fopen(fileName.c_str(), "rb"))
+    {
+        char buf[4096];
+        for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;)
+            bytes.append(buf, n);
+        std::fclose(f);
+    }
+    std::uint64_t indexOffset = 0;
+    std::memcpy(&indexOffset, bytes.data() + 24, sizeof(indexOffset));
+
+    auto opensPatched = [&](std::size_t at, const void* value, std::size_t size)
+    {
+        std::string patched = bytes;
+        std::memcpy(&patched[at], value, size);
+        const std::string name = "test_blocks_bad.pbb";
+        if (FILE* f = std::fopen(name.c_str(), "wb"))
+        {
+            std::fwrite(patched.data(), 1, patched.size(), f);
+            std::fclose(f);
+        }
+        ContactBlockStore bad;
+        return bad.open(name);
+    };
+
+    const std::uint32_t hugeRaw = 0xFFFFFFF0;
+    const std::uint64_t zeroOffset = 0;
+    const std::uint32_t manyBlocks = 0x7FFFFFFF;
+    printResult("huge rawSize rejected", opensPatched(indexOffset + 12, &hugeRaw, sizeof(hugeRaw)), false);
+    printResult("offset inside header rejected", opensPatched(indexOffset, &zeroOffset, sizeof(zeroOffset)), false);
+    printResult("block count rejected", opensPatched(16, &manyBlocks, sizeof(manyBlocks)), false);
+    printResult("contact count rejected", opensPatched(indexOffset + 16, &manyBlocks, sizeof(manyBlocks)), false);
+    printResult("unpatched opens", opensPatched(0, bytes.data(), 1), true);
+}
+
+void testImport()
+{
+    std::cout << "\n=== TEST IMPORT CSV / VCARD ===\n";
+
+    auto writeFile = [](const std::string& name, const std::string& text)
+    {
+        if (FILE* f = std::fopen(name.c_str(), "wb"))
+        {
+            std::fwrite(text.data(), 1, text.size(), f);
+            std::fclose(f);
+        }
+    };
+
+    const std::string csvName = "test_import.csv";
+    writeFile(csvName,
+              "\xEF\xBB\xBFlast_name;first_name;middle_name;address;birth_date;email;phones\r\n"
+              "Иванов;Пётр;;\"Москва; ул. Ленина\";2000-01-01;a@mail.ru;+79990001122|home\r\n"
+              "\r\n"
+              "Петров;Иван;Сергеевич;\"многострочный\n адрес\";15.05.1990;b@mail.ru;"
+              "\"+79990001123; 8(999)000-11-24|work\"\r\n"
+              "-Плохой;Иван;;;2000-01-01;c@mail.ru;+79990001125\r\n"
+              "Сидоров;Иван;;;2000-01-01;c@mail.ru;\r\n");
+
+    std::vector<Contact> got;
+    std::vector<ContactImporter::Rejection> rejected;
+    ContactImporter::Stats stats;
+
+    bool ok = ContactImporter::importFile(csvName, ImportFormat::Csv,
+        [&](std::vector<Contact>&& batch)
+        {
+            for (auto& c : batch)
+                got.push_back(std::move(c));
+            return true;
+        },
+        [&](const ContactImporter::Rejection& r) { rejected.push_back(r); },
+        &stats, 2);
+
+    printResult("csv import", ok, true);
+    printResult("csv accepted == 2", stats.accepted == 2 && got.size() == 2, true);
+    printResult("csv quoted delimiter",
+                got.size() == 2 && got[0].address() == "Москва; ул. Ленина", true);
+    printResult("csv phones",
+                got.size() == 2 && got[1].phones().size() == 2
+                    && got[1].phones()[1].type() == PhoneType::Work
+                    && got[1].birthDate().toString() == "1990-05-15", true);
+    printResult("csv rejected lines 6, 7",
+                rejected.size() == 2 && rejected[0].line == 6 && rejected[1].line == 7, true);
+
+    const std::string vcfName = "test_import.vcf";
+    writeFile(vcfName,
+              "BEGIN:VCARD\r\n"
+              "VERSION:3.0\r\n"
+              "N:Кузнецов;Мария;Ивановна;;\r\n"
+              "ADR;TYPE=home:;;ул. Мира\\, 5;Казань;;;\r\n"
+              "BDAY:19851231\r\n"
+              "EMAIL:m@mail.ru\r\n"
+              "TEL;TYPE=CELL:+7999000\r\n"
+              " 1126\r\n"
+              "item1.TEL;TYPE=work,voice:8(999)0001127\r\n"
+              "END:VCARD\r\n"
+              "BEGIN:VCARD\r\n"
+              "N:Без;Телефона;;;\r\n"
+              "EMAIL:x@mail.ru\r\n"
+              "BDAY:1985-01-01\r\n"
+              "END:VCARD\r\n");
+
+    got.clear();
+    rejected.clear();
+    ok = ContactImporter::importFile(vcfName, ImportFormat::VCard,
+        [&](std::vector<Contact>&& batch)
+        {
+            for (auto& c : batch)
+                got.push_back(std::move(c));
+            return true;
+        },
+        [&](const ContactImporter::Rejection& r) { rejected.push_back(r); });
+
+    printResult("vcard import", ok, true);
+    printResult("vcard accepted == 1", got.size() == 1, true);
+    printResult("vcard fields",
+                got.size() == 1 && got[0].middleName() == "Ивановна"
+                    && got[0].address() == "ул. Мира, 5, Казань"
+                    && got[0].phones().size() == 2
+                    && got[0].phones()[0].number() == "+79990001126"
+                    && got[0].phones()[1].type() == PhoneType::Work, true);
+    printResult("vcard rejected line 11", rejected.size() == 1 && rejected[0].line == 11, true);
+
+    std::remove(csvName.c_str());
+    std::remove(vcfName.c_str());
+}
+
+void testExport()
+{
+    std::cout << "\n=== TEST EXPORT ===\n";
+
+    ContactBook book;
+    Contact a("Иванов", "Пётр", "", "Москва, ул. \"Ленина\"; д. 1", Date::fromString("2000-01-01"), "a@mail.ru");
+    a.addPhone(PhoneNumber("+79990001122", PhoneType::Home));
+    a.addPhone(PhoneNumber("8(999)000-11-23", PhoneType::Work));
+    Contact b("Петров", "Иван", "Сергеевич", "", Date::fromString("1990-05-15"), "b@mail.ru");
+    b.addPhone(PhoneNumber("+79990001124", PhoneType::Other));
+    book.addContact(a);
+    book.addContact(b);
+
+    auto readBack = [](const std::string& name, ImportFormat format)
+    {
+        std::vector<Contact> got;
+        ContactImporter::importFile(name, format, [&](std::vector<Contact>&& batch)
+        {
+            for (auto& c : batch)
+                got.push_back(std::move(c));
+            return true;
+        }, nullptr);
+        return got;
+    };
+
+    auto same = [](const Contact& x, const Contact& y)
+    {
+        if (x.lastName() != y.lastName() || x.firstName() != y.firstName()
+            || x.middleName() != y.middleName() || x.address() != y.address()
+            || x.birthDate().toString() != y.birthDate().toString()
+            || x.email() != y.email() || x.phones().size() != y.phones().size())
+            return false;
+        for (std::size_t i = 0; i < x.phones().size(); ++i)
+        {
+            if (x.phones()[i].number() != y.phones()[i].number()
+                || x.phones()[i].type() != y.phones()[i].type())
+                return false;
+        }
+        return true;
+    };
+
+    const std::string csvName = "test_export.csv";
+    printResult("export csv", book.exportToFile(csvName, ExportFormat::Csv), true);
+    auto csv = readBack(csvName, ImportFormat::Csv);
+    printResult("csv round trip",
+                csv.size() == 2 && same(csv[0], a) && same(csv[1], b), true);
+
+    const std::string vcfName = "test_export.vcf";
+    printResult("export vcard", book.exportToFile(vcfName, ExportFormat::VCard), true);
+    auto vcf = readBack(vcfName, ImportFormat::VCard);
+    printResult("vcard round trip",
+                vcf.size() == 2 && same(vcf[0], a) && same(vcf[1], b), true);
+
+    // только результат поиска
+    const std::vector<std::size_t> found = book.find("Петров");
+    book.exportToFile(csvName, ExportFormat::Csv, &found);
+    csv = readBack(csvName, ImportFormat::Csv);
+    printResult("filtered export", csv.size() == 1 && same(csv[0], b), true);
+
+    std::string json;
+    ContactExporter::appendRecord(json, a, ExportFormat::JsonLines);
+    printResult("json escaping",
+                json.find("\"address\":\"Москва, ул. \\\"Ленина\\\"; д. 1\"") != std::string::npos
+                    && json.back() == '\n', true);
+
+    std::remove(csvName.c_str());
+    std::remove(vcfName.c_str());
+}
+
+void testStringInterning()
+{
+    std::cout << "\n=== TEST STRING INTERNING ===\n";
+
+    ContactBook book;
+    printResult("interning by default", book.stringInterning(), true);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        Contact c("Иванов", "Александр", "Сергеевич", "Санкт-Петербург, Невский проспект",
+                  Date::fromString("1990-01-01"), "user" + std::to_string(i) + "@mail.ru");
+        c.addPhone(PhoneNumber("+7999000112" + std::to_string(i), PhoneType::Mobile));
+        book.addContact(c);
+    }
+
+    const auto& list = book.contacts();
+    printResult("same value shared",
+                &list[0].address() == &list[9].address()
+                    && &list[0].firstName() == &list[5].firstName(), true);
+    printResult("different values kept", list[3].email() == "user3@mail.ru", true);
+
+    const auto stats = book.stringStats();
+    printResult("address unique == 1", stats[3].field == "address" && stats[3].unique == 1, true);
+    printResult("last name unique == 1", stats[0].unique == 1 && stats[0].values == 10, true);
+    printResult("address saved", stats[3].savedBytes() > 0, true);
+
+    // копия контакта переживает справочник
+    Contact copy = list[0];
+    book.clear();
+    printResult("copy after clear", copy.address() == "Санкт-Петербург, Невский проспект", true);
+
+    // изменение поля не трогает другие контакты с тем же значением
+    book.addContact(copy);
+    book.addContact(copy);
+    Contact changed = book.contacts()[1];
+    changed.setFirstName("Пётр");
+    book.updateContact(1, changed);
+    printResult("update isolated",
+                book.contacts()[0].firstName() == "Александр"
+                    && book.contacts()[1].firstName() == "Пётр", true);
+}
+
+void testContactStore()
+{
+    std::cout << "\n=== TEST CONTACT STORE ===\n";
+
+    ContactBook book;
+    Contact a("Петров", "Иван", "", "Москва", Date::fromString("1990-05-01"), "ivan@mail.ru");
+    a.addPhone(PhoneNumber("+79990001122", PhoneType::Mobile));
+    Contact b("Сидоров", "Анна", "Петровна", "Тверь", Date::fromString("1985-12-31"), "anna@mail.ru");
+    Contact c("Абрамов", "Олег", "", "Петрозаводск", Date::fromString("1990-04-30"), "oleg@mail.ru");
+    c.addPhone(PhoneNumber("+78120000000", PhoneType::Home));
+    c.addPhone(PhoneNumber("+79995554433", PhoneType::Work));
+    book.addContact(a);
+    book.addContact(b);
+    book.addContact(c);
+
+    const ContactStore& store = book.columns();
+    printResult("columns size == 3", store.size() == 3, true);
+    printResult("middle name column", store.text(ContactStore::MiddleName, 1) == "Петровна", true);
+    printResult("phones flattened",
+                store.phoneCount(1) == 0 && store.phoneCount(2) == 2
+                    && store.phone(2, 1) == "+79995554433", true);
+
+    printResult("find in several fields", book.find("Петр") == std::vector<std::size_t>{0, 1, 2}, true);
+    printResult("find phone after contact without phones",
+                book.find("5554") == std::vector<std::size_t>{2}, true);
+    // «ПетровИван» — склейка соседних значений столбца, а не значение
+    printResult("no match across records", book.find("ПетровСидоров").empty(), true);
+
+    book.addContact(Contact("Яковлев", "", "", "", Date::fromString("2000-01-01"), "ya@mail.ru"));
+    printResult("appended contact found", book.find("Яковлев") == std::vector<std::size_t>{3}, true);
+
+    book.sortBy(SortField::BirthDate, true);
+    printResult("sorted by date",
+                book.contacts()[0].lastName() == "Сидоров" && book.contacts()[1].lastName() == "Абрамов"
+                    && book.columns().text(ContactStore::LastName, 1) == "Абрамов", true);
+    printResult("phones follow contact", book.columns().phone(1, 0) == "+78120000000", true);
+
+    book.sortBy(SortField::LastName, false);
+    printResult("sorted by last name desc", book.contacts()[0].lastName() == "Яковлев", true);
+
+    book.removeContact(0);
+    printResult("removed contact gone", book.find("Яковлев").empty(), true);
+}
+
+void testInlinePhones()
+{
+    std::cout << "\n=== TEST INLINE PHONES ===\n";
+
+    PhoneNumber shortNum("+7 (999) 123-45-67", PhoneType::Home);
+    const std::string longText = "+7 (999) 123-45-67 доб. 12345";
+    PhoneNumber longNum(longText, PhoneType::Work);
+    printResult("short number kept", shortNum.number() == "+7 (999) 123-45-67", true);
+    printResult("long number kept", longNum.number() == longText, true);
+
+    PhoneNumber moved(std::move(longNum));
+    PhoneNumber copied = moved;
+    copied.setNumber(copied.number().substr(0, 5)); // из собственного буфера
+    printResult("move / copy / self set",
+                moved.number() == longText && longNum.number().empty()
+                    && copied.number() == "+7 (9" && copied.type() == PhoneType::Work, true);
+
+    Contact c;
+    for (int i = 0; i < 3; ++i)
+        c.addPhone(PhoneNumber("+7999000112" + std::to_string(i), PhoneType::Mobile));
+    printResult("three phones inline", c.phones().isInline() && c.phones().size() == 3, true);
+
+    Contact copy = c;
+    c.addPhone(shortNum);
+    printResult("fourth phone spills to heap",
+                !c.phones().isInline() && c.phones().size() == 4
+                    && c.phones()[3].number() == shortNum.number()
+                    && c.phones()[0].number() == "+79990001120", true);
+
+    Contact stolen = std::move(c);
+    printResult("copy / move of phone list",
+                copy.phones().size() == 3 && copy.phones()[2].number() == "+79990001122"
+                    && stolen.phones().size() == 4 && c.phones().empty(), true);
+}
+
+void testPhoneCanonical()
+{
+    std::cout << "\n=== TEST PHONE CANONICAL ===\n";
+
+    const PhoneNumber a("+78121234567", PhoneType::Home);
+    const PhoneNumber b("8(812)123-45-67", PhoneType::Home);
+    const PhoneNumber c("8(812)123-45-67", PhoneType::Work);
+    printResult("same number, other text", a == b && a.key() == b.key(), true);
+    printResult("display text kept", b.number() == "8(812)123-45-67", true);
+    printResult("type is part of key", a == c, false);
+    printResult("sameNumber ignores type", a.sameNumber(c) && c.type() == PhoneType::Work, true);
+    printResult("hash equal", std::hash<PhoneNumber>()(a) == std::hash<PhoneNumber>()(b), true);
+    printResult("leading zeros matter",
+                PhoneNumber::canonicalize("0123") != PhoneNumber::canonicalize("123"), true);
+    printResult("no digits -> 0", PhoneNumber::canonicalize("нет") == 0, true);
+    printResult("ordered by number",
+                PhoneNumber("+79990000000", PhoneType::Mobile) < PhoneNumber("89990000001", PhoneType::Mobile),
+                true);
+
+    ContactBook book;
+    Contact x("Петров", "Иван", "", "", Date(1990, 1, 1), "x@mail.ru");
+    x.addPhone(a);
+    Contact y("Сидоров", "Пётр", "", "", Date(1990, 1, 1), "y@mail.ru");
+    y.addPhone(PhoneNumber("+79990001122", PhoneType::Mobile));
+    y.addPhone(PhoneNumber("8 812 123 45 67", PhoneType::Work));
+    book.addContact(x);
+    book.addContact(y);
+
+    printResult("findByPhone across forms",
+                book.findByPhone("8(812)123-45-67") == std::vector<std::size_t>{0, 1}, true);
+    printResult("find matches canonical phone",
+                book.find("+7 (999) 000-11-22") == std::vector<std::size_t>{1}, true);
+}
+
+void testContactHandles()
+{
+    std::cout << "\n=== TEST CONTACT HANDLES ===\n";
+
+    ContactBook book;
+    std::vector<ContactHandle> handles;
+    for (int i = 0; i < 5; ++i)
+        handles.push_back(book.addContact(Contact("Фамилия" + std::to_string(i), "Имя", "", "",
+                                                  Date(1990 + i, 1, 1), "")));
+
+    printResult("remove by handle", book.removeContact(handles[1]), true);
+    printResult("stale handle not found",
+                book.contact(handles[1]) == nullptr && !book.removeContact(handles[1]), true);
+    printResult("other handles still valid",
+                book.contact(handles[4]) && book.contact(handles[4])->lastName() == "Фамилия4"
+                    && book.contact(handles[0])->lastName() == "Фамилия0", true);
+    printResult("dense after remove, order kept",
+                book.contacts().size() == 4 && book.indexOf(handles[2]) == 1 && book.indexOf(handles[4]) == 3, true);
+
+    // слот переиспользуется, но старый handle на него не указывает
+    const ContactHandle reused = book.addContact(Contact("Новый", "Имя", "", "", Date(2000, 1, 1), ""));
+    printResult("reused slot, new generation",
+                reused.slot == handles[1].slot && reused != handles[1]
+                    && book.contact(handles[1]) == nullptr, true);
+
+    book.sortBy(SortField::BirthDate, false);
+    printResult("handles survive sort",
+                book.indexOf(reused) == 0 && book.contact(handles[3])->lastName() == "Фамилия3", true);
+
+    // удаление после сортировки не ломает её
+    book.sortBy(SortField::LastName);
+    book.removeContact(handles[0]);
+    bool sorted = book.contacts().size() == 4;
+    for (std::size_t i = 1; i < book.contacts().size(); ++i)
+        sorted = sorted && book.contacts()[i - 1].lastName() <= book.contacts()[i].lastName();
+    printResult("sorted after remove", sorted, true);
+
+    Contact changed = *book.contact(handles[2]);
+    changed.setFirstName("Пётр");
+    printResult("update by handle",
+                book.updateContact(handles[2], changed) && book.contact(handles[2])->firstName() == "Пётр",
+                true);
+
+    book.clear();
+    printResult("clear invalidates handles", book.contact(reused) == nullptr, true);
+}
+
+void testBulkChanges()
+{
+    std::cout << "\n=== TEST BULK CHANGES ===\n";
+
+    ContactBook book;
+    const std::string email = "long.address.beyond.sso@example.com";
+
+    Contact moved("Иванов", "Иван", "", "", Date(1990, 1, 1), email);
+    const ContactHandle a = book.addContact(std::move(moved));
+    printResult("add by move", book.contact(a) && book.contact(a)->email() == email, true);
+
+    const ContactHandle b = book.emplaceContact("Петров", "Пётр", "", "", Date(1991, 2, 2), email);
+    printResult("emplace", book.contact(b) && book.contact(b)->lastName() == "Петров", true);
+
+    std::vector<Contact> batch;
+    for (int i = 0; i < 3; ++i)
+        batch.emplace_back("Сидоров" + std::to_string(i), "Сидор", "", "", Date(1992, 3, 3), email);
+    const std::vector<Contact> copySource = batch;
+
+    std::vector<ContactHandle> handles;
+    book.addContacts(copySource, &handles);
+    printResult("addContacts copies lvalue range",
+                handles.size() == 3 && copySource[2].email() == email
+                    && book.contact(handles[2])->lastName() == "Сидоров2", true);
+
+    // столбцы построены — следующая пачка должна дописаться в них
+    printResult("columns before bulk add", book.find("Сидоров1").size() == 1, true);
+
+    handles.clear();
+    book.addContacts(std::move(batch), &handles);
+    printResult("addContacts moves rvalue range",
+                handles.size() == 3 && book.contacts().size() == 8
+                    && book.contact(handles[0])->lastName() == "Сидоров0", true);
+
+    printResult("columns follow bulk add", book.find("Сидоров1").size() == 2, true);
+
+    std::vector<ContactChange> changes;
+    changes.push_back(ContactChange::remove(a));
+    changes.push_back(ContactChange::update(b, Contact("Петрова", "Анна", "", "", Date(1991, 2, 2), email)));
+    changes.push_back(ContactChange::add(Contact("Новиков", "Олег", "", "", Date(1993, 4, 4), email)));
+    changes.push_back(ContactChange::remove(a)); // уже удалён — пропускается
+
+    std::vector<ContactHandle> added;
+    const std::size_t applied = book.applyChanges(std::move(changes), &added);
+    printResult("applyChanges count", applied == 3 && added.size() == 1, true);
+    printResult("applyChanges result",
+                book.contact(a) == nullptr && book.contact(b)->lastName() == "Петрова"
+                    && book.contact(added[0])->firstName() == "Олег" && book.contacts().size() == 8, true);
+    printResult("applyChanges keeps order",
+                book.indexOf(b) == 0 && book.contacts()[1].lastName() == "Сидоров0"
+                    && book.indexOf(added[0]) == 7, true);
+    printResult("columns after applyChanges",
+                book.find("Петрова").size() == 1 && book.find("Иванов").empty(), true);
+}
+
+void testSearchIndex()
+{
+    std::cout << "\n=== TEST SEARCH INDEX ===\n";
+
+    ContactBook indexed;
+    ContactBook plain;
+    plain.setSearchIndex(false);
+
+    const char* lastNames[] = { "Иванов", "Петрова", "Smith", "Кузнецов" };
+    std::vector<ContactHandle> ih, ph;
+    for (int i = 0; i < 40; ++i)
+    {
+        Contact c(lastNames[i % 4] + std::to_string(i % 7), "Анна", "", "ул. Мира, д. " + std::to_string(i),
+                  Date(1980 + i % 30, 1 + i % 12, 1 + i % 28), "user" + std::to_string(i) + "@mail.ru");
+        c.addPhone(PhoneNumber("+7812" + std::to_string(5550000 + i), PhoneType::Home));
+        ih.push_back(indexed.addContact(c));
+        ph.push_back(plain.addContact(c));
+    }
+
+    const std::vector<std::string> queries = { "Иванов", "ванов1", "Smith3", "Мира, д. 1", "@mail",
+                                               "user12@", "8(812)555-00-07", "5550013", "нет такого",
+                                               "ов", "1" };
+    auto same = [&]()
+    {
+        for (const auto& q : queries)
+        {
+            if (indexed.find(q) != plain.find(q))
+                return false;
+        }
+        return indexed.findByPhone("88125550007") == plain.findByPhone("88125550007");
+    };
+
+    printResult("index matches scan", same(), true);
+    printResult("index used", indexed.index().postingCount() > 0, true);
+
+    // изменения после построения индекса
+    for (int i = 0; i < 40; i += 3)
+    {
+        indexed.removeContact(ih[i]);
+        plain.removeContact(ph[i]);
+    }
+    Contact renamed("Иванова", "Мария", "", "пр. Мира", Date(1990, 5, 5), "maria@mail.ru");
+    indexed.updateContact(ih[1], renamed);
+    plain.updateContact(ph[1], renamed);
+    indexed.addContact(renamed); // слот удалённого контакта
+    plain.addContact(renamed);
+    printResult("index after edits", same() && indexed.find("Мария").size() == 2, true);
+
+    indexed.sortBy(SortField::LastName);
+    plain.sortBy(SortField::LastName);
+    printResult("index after sort", same(), true);
+}
+
+void testCaseFolding()
+{
+    std::cout << "\n=== TEST CASE FOLDING ===\n";
+
+    printResult("fold latin and cyrillic", SearchKey::fold("ИВАНОВ Ivan ЯЁЖ") == "иванов ivan яёж", true);
+    printResult("fold keeps lowercase and other text",
+                SearchKey::fold("ёлка, ул. Мира 5 – №7") == "ёлка, ул. мира 5 – №7", true);
+    printResult("fold Ѐ..Џ and À..Þ", SearchKey::fold("ЂЏ ÀÉÞ×") == "ђџ àéþ×", true);
+    printResult("fold keeps byte length", SearchKey::fold("ЁЖИК").size() == std::string("ЁЖИК").size(), true);
+
+    ContactBook book;
+    const ContactHandle a = book.addContact(Contact("Ёлкин", "Пётр", "", "Москва", Date(1990, 1, 1), "PETR@Mail.ru"));
+    book.addContact(Contact("Иванов", "Иван", "", "ЁЛКИНО", Date(1991, 1, 1), "ivan@mail.ru"));
+
+    printResult("find ignores case", book.find("ёлкин") == std::vector<std::size_t>{0, 1}, true);
+    printResult("find upper query", book.find("ПЁТР") == std::vector<std::size_t>{0}, true);
+    printResult("find latin upper", book.find("petr@mail") == std::vector<std::size_t>{0}, true);
+    printResult("find short query", book.find("ё") == std::vector<std::size_t>{0, 1}, true);
+    printResult("find across fields like filter", book.find("иванов иван") == std::vector<std::size_t>{1}, true);
+
+    book.updateContact(a, Contact("Смирнов", "Пётр", "", "Москва", Date(1990, 1, 1), "petr@mail.ru"));
+    printResult("key follows update",
+                book.find("ЁЛКИН") == std::vector<std::size_t>{1} && book.searchKey(0).find("смирнов") == 0, true);
+
+    ContactBook plain;
+    plain.setSearchIndex(false);
+    plain.addContact(*book.contact(a));
+    printResult("same without index", plain.find("СМИРНОВ") == std::vector<std::size_t>{0}, true);
+}
+
+void testPhoneDigits()
+{
+    std::cout << "\n=== TEST PHONE DIGITS ===\n";
+
+    char buf[PhoneNumber::kMaxDigits];
+    const std::uint64_t key = PhoneNumber::canonicalize("8(812)123-45-67");
+    printResult("canonical digits", std::string(buf, PhoneNumber::digits(key, buf)) == "78121234567", true);
+
+    for (bool indexed : { true, false })
+    {
+        ContactBook book;
+        book.setSearchIndex(indexed);
+        const std::string mode = indexed ? " (index)" : " (scan)";
+
+        Contact a("Иванов", "Иван", "", "", Date(1990, 1, 1), "");
+        a.addPhone(PhoneNumber("+7(812)123-45-67", PhoneType::Home));
+        Contact b("Петров", "Пётр", "", "", Date(1991, 1, 1), "");
+        b.addPhone(PhoneNumber("8 999 000-12-34", PhoneType::Mobile));
+        b.addPhone(PhoneNumber("495 1234567", PhoneType::Work));
+        const ContactHandle ha = book.addContact(a);
+        const ContactHandle hb = book.addContact(b);
+
+        printResult("infix across formatting" + mode,
+                    book.findByDigits("1234567") == std::vector<ContactHandle>{ ha, hb }, true);
+        printResult("infix fragment" + mode, book.findByDigits("812-123") == std::vector<ContactHandle>{ ha }, true);
+        printResult("prefix" + mode,
+                    book.findByDigits("7999", DigitMatch::Prefix) == std::vector<ContactHandle>{ hb }
+                        && book.findByDigits("999", DigitMatch::Prefix).empty(), true);
+        printResult("suffix" + mode,
+                    book.findByDigits("1234", DigitMatch::Suffix) == std::vector<ContactHandle>{ hb }
+                        && book.findByDigits("4567", DigitMatch::Suffix) == std::vector<ContactHandle>{ ha, hb }, true);
+        printResult("find uses digits" + mode, book.find("812123") == std::vector<std::size_t>{ 0 }, true);
+
+        // изменения после построения индекса
+        Contact changed("Петров", "Пётр", "", "", Date(1991, 1, 1), "");
+        changed.addPhone(PhoneNumber("+7 (383) 765-43-21", PhoneType::Mobile));
+        book.updateContact(hb, changed);
+        book.removeContact(ha);
+        printResult("digits after edits" + mode,
+                    book.findByDigits("1234567").empty()
+                        && book.findByDigits("7654321") == std::vector<ContactHandle>{ hb }, true);
+    }
+
+    // больше kPendingNumbers — часть номеров уже в суффиксном массиве
+    ContactBook big;
+    for (std::size_t i = 0; i < ContactIndex::kPendingNumbers + 100; ++i)
+    {
+        Contact c("Фамилия", "Имя", "", "", Date(2000, 1, 1), "");
+        c.addPhone(PhoneNumber("+7 912 " + std::to_string(1000000 + i), PhoneType::Mobile));
+        big.addContact(c);
+    }
+    big.index();
+    Contact late("Поздний", "Имя", "", "", Date(2000, 1, 1), "");
+    late.addPhone(PhoneNumber("+7 912 9990000", PhoneType::Mobile));
+    const ContactHandle hl = big.addContact(late);
+    printResult("sorted and pending numbers",
+                big.findByDigits("1000042").size() == 1 && big.findByDigits("9990000") == std::vector<ContactHandle>{ hl }
+                    && big.findByDigits("7912", DigitMatch::Prefix).size() == big.contacts().size(), true);
+}
+
+void testIncrementalSearch()
+{
+    std::cout << "\n=== TEST INCREMENTAL SEARCH ===\n";
+
+    ContactBook book;
+    const char* lastNames[] = { "Иванов", "Иваненко", "Ивлев", "Петров" };
+    for (int i = 0; i < 20; ++i)
+    {
+        Contact c(lastNames[i % 4], "Анна", "", "ул. Мира, д. " + std::to_string(i), Date(1990, 1, 1), "");
+        c.addPhone(PhoneNumber("+7(812)" + std::to_string(1000000 + i * 37), PhoneType::Home));
+        book.addContact(c);
+    }
+
+    IncrementalSearch search(book);
+    bool same = true;
+    bool refined = true;
+    std::string typed;
+    for (const std::string letter : { "и", "в", "а", "н", "о" })
+    {
+        typed += letter;
+        same = same && search.search(typed) == book.find(typed);
+        refined = refined && (typed.size() == letter.size() || search.lastStep() == IncrementalSearch::Step::Refined);
+    }
+    printResult("typing matches find", same, true);
+    printResult("each letter refines", refined, true);
+
+    // стёрли букву — результат из стопки
+    const std::vector<std::size_t> back = search.search("иван");
+    printResult("backspace from cache",
+                search.lastStep() == IncrementalSearch::Step::Cached && back == book.find("иван"), true);
+    search.search("ива");
+    printResult("backspace twice from cache", search.lastStep() == IncrementalSearch::Step::Cached, true);
+
+    search.search("петров");
+    printResult("other query searches book", search.lastStep() == IncrementalSearch::Step::Full, true);
+
+    // номер: «78» не содержится в «+7(812)...», а «781» — уже кусок номера
+    search.search("78");
+    printResult("digits extend beyond previous",
+                search.search("781") == book.find("781") && !book.find("781").empty(), true);
+
+    search.search("ивл");
+    book.addContact(Contact("Ивлева", "Мария", "", "", Date(1991, 1, 1), ""));
+    const std::vector<std::size_t> afterAdd = search.search("ивле");
+    printResult("book change resets stack",
+                search.lastStep() == IncrementalSearch::Step::Full && afterAdd == book.find("ивле")
+                    && afterAdd.size() == 1 + 5, true);
+}
+
+void testSubstringScan()
+{
+    std::cout << "\n=== TEST SUBSTRING SCAN ===\n";
+
+    // записи разной длины, пустые, кириллица; образцы на стыках записей
+    const std::vector<std::string> records = {
+        "иванов иван", "", "ab", "cab", "abc", "", "петров пётр +78121234567",
+        std::string(40, 'a') + "b", "x", "иваненко", std::string(70, 'z') + "иван", "b"
+    };
+    std::string text;
+    std::vector<std::size_t> offsets(1, 0);
+    for (const auto& r : records)
+    {
+        text += r;
+        offsets.push_back(text.size());
+    }
+
+    const std::vector<std::string> needles = {
+        "a", "b", "ab", "bc", "abc", "ca", "иван", "ов", "z", std::string(40, 'a'),
+        std::string(41, 'a'), "zи", "bx", "812", "нет такого", "xи", "cab"
+    };
+
+    const SubstringScan::Kernel kernels[] = {
+        SubstringScan::Kernel::Scalar, SubstringScan::Kernel::Sse2, SubstringScan::Kernel::Avx2
+    };
+    for (SubstringScan::Kernel kernel : kernels)
+    {
+        bool same = true;
+        std::vector<std::size_t> found;
+        for (const auto& needle : needles)
+        {
+            std::vector<std::size_t> expected;
+            for (std::size_t i = 0; i < records.size(); ++i)
+            {
+                if (records[i].find(needle) != std::string::npos)
+                    expected.push_back(i);
+            }
+            SubstringScan::scan(text, offsets, needle, found, kernel);
+            same = same && found == expected;
+        }
+        printResult(std::string("kernel ") + SubstringScan::name(kernel) + " matches find", same, true);
+    }
+
+    // поиск без индекса идёт через общий буфер ключей — тот же результат
+    ContactBook book;
+    book.setSearchIndex(false);
+    book.addContact(Contact("Иванов", "Иван", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Петров", "Пётр", "", "", Date(1990, 1, 1), ""));
+    const bool before = book.find("ИВАН") == std::vector<std::size_t>{ 0 };
+    book.addContact(Contact("Иваненко", "Анна", "", "", Date(1990, 1, 1), ""));
+    const bool appended = book.find("иван") == std::vector<std::size_t>{ 0, 2 };
+    book.removeContact(std::size_t(0));
+    // на место первого встал последний
+    const bool removed = book.find("иван") == std::vector<std::size_t>{ 0 }
+                         && book.find("петр") == std::vector<std::size_t>{ 1 };
+    printResult("book scan after add", before && appended, true);
+    printResult("book scan after remove", removed, true);
+}
+
+void testFuzzySearch()
+{
+    std::cout << "\n=== TEST FUZZY SEARCH ===\n";
+
+    ContactBook book;
+    book.addContact(Contact("Петров", "Иван", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Иванова", "Анна", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Иванов", "Пётр", "Иванович", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Сидоров", "Анна-Мария", "", "", Date(1990, 1, 1), ""));
+
+    auto indices = [](const std::vector<FuzzyMatch>& found) {
+        std::vector<std::size_t> out;
+        for (const auto& m : found)
+            out.push_back(m.index);
+        return out;
+    };
+
+    // «иванав»: Иванов — одна опечатка, Иванова — две; Иван (имя) — две, но ниже фамилии
+    const std::vector<FuzzyMatch> found = book.findFuzzy("Иванав");
+    printResult("typo finds surname first",
+                !found.empty() && found[0].index == 2 && found[0].distance == 1, true);
+    printResult("ranked by typos, then field",
+                indices(found) == std::vector<std::size_t>{ 2, 1, 0 }, true);
+    printResult("top-k bounded", indices(book.findFuzzy("Иванав", 2)) == std::vector<std::size_t>{ 2, 1 }, true);
+
+    // каждое слово запроса должно совпасть; короткие слова — без опечаток
+    printResult("all words must match", indices(book.findFuzzy("иванав петр")) == std::vector<std::size_t>{ 2 }, true);
+    printResult("short word exact only", book.findFuzzy("ан").empty(), true);
+    printResult("double name by parts", indices(book.findFuzzy("маря")) == std::vector<std::size_t>{ 3 }, true);
+
+    // словарь следует за изменениями справочника
+    book.addContact(Contact("Smith", "John", "", "", Date(1990, 1, 1), ""));
+    printResult("added contact found", indices(book.findFuzzy("SMYTH")) == std::vector<std::size_t>{ 4 }, true);
+    book.removeContact(std::size_t(2));
+    const std::vector<FuzzyMatch> afterRemove = book.findFuzzy("Иванав");
+    printResult("removed contact gone", indices(afterRemove) == std::vector<std::size_t>{ 1, 0 }, true);
+}
+
+void testContactQuery()
+{
+    std::cout << "\n=== TEST CONTACT QUERY ===\n";
+
+    ContactQuery q;
+    const bool parsed = ContactQuery::parse("last:Иванов phone:8-12 born:1980..1990 type:work email:@corp", q);
+    printResult("query parsed", parsed && q.terms().size() == 5, true);
+    printResult("phone keeps digits", parsed && q.terms()[1].value == "812", true);
+    printResult("born years inclusive",
+                parsed && q.terms()[2].from == Date(1980, 1, 1) && q.terms()[2].to == Date(1990, 12, 31), true);
+    printResult("type parsed", q.phoneType() && *q.phoneType() == PhoneType::Work, true);
+
+    ContactQuery quoted;
+    printResult("quoted value",
+                ContactQuery::parse("address:\"Невский пр.\" 12:30", quoted) && quoted.terms().size() == 2
+                    && quoted.terms()[0].value == "Невский пр."
+                    && quoted.terms()[1].field == ContactQuery::Field::Any, true);
+    ContactQuery mixedCase;
+    printResult("field and type case ignored",
+                ContactQuery::parse("Last:Иванов TYPE:Work", mixedCase) && mixedCase.terms().size() == 2
+                    && mixedCase.terms()[0].field == ContactQuery::Field::LastName
+                    && mixedCase.phoneType() && *mixedCase.phoneType() == PhoneType::Work, true);
+    printResult("unknown key is plain text", ContactQuery::isStructured("12:30 иван"), false);
+    printResult("known key is structured", ContactQuery::isStructured("иван born:1990"), true);
+
+    std::string error;
+    const char* bad[] = { "born:abc", "born:1990..1980", "type:fax", "phone:abc", "last:", "type:work type:home" };
+    bool rejected = true;
+    for (const char* text : bad)
+        rejected = rejected && !ContactQuery::parse(text, q, &error) && !error.empty();
+    printResult("bad queries rejected", rejected, true);
+
+    ContactBook book;
+    const char* lastNames[] = { "Иванов", "Петров", "Сидорова", "Smith" };
+    for (int i = 0; i < 60; ++i)
+    {
+        Contact c(lastNames[i % 4], i % 3 ? "Анна" : "Пётр", "", "ул. Мира, д. " + std::to_string(i),
+                  Date(1970 + i % 30, 1 + i % 12, 1 + i % 28), i % 5 ? "user@mail.ru" : "boss@corp.ru");
+        c.addPhone(PhoneNumber("+7(812)" + std::to_string(1000000 + i * 37), i % 2 ? PhoneType::Work : PhoneType::Home));
+        book.addContact(c);
+    }
+
+    // тот же ответ с индексами и без (просмотр всех контактов)
+    const char* queries[] = {
+        "last:иванов", "last:ов first:анна", "phone:812 type:work", "born:1980..1985 email:@corp",
+        "born:1973-04-04", "иван born:..1975", "first:пётр address:\"мира, д. 1\"", "type:home",
+        "phone:1000037", "8121000074 type:home", "last:smith born:1999..", "last:нет такой"
+    };
+    ContactBook scan;
+    scan.setSearchIndex(false);
+    for (const auto& c : book.contacts())
+        scan.addContact(c);
+
+    bool same = true;
+    bool found = true;
+    for (const char* text : queries)
+    {
+        ContactQuery query;
+        same = same && ContactQuery::parse(text, query) && book.findQuery(query) == scan.findQuery(query);
+        found = found && (book.findQuery(query).empty() == (std::string(text) == "last:нет такой"));
+    }
+    printResult("indexed plan matches scan", same, true);
+    printResult("queries find contacts", found, true);
+
+    // условия проверяются по своему полю: «анна» в имени, а не в фамилии
+    ContactQuery lastAnna;
+    ContactQuery::parse("last:анна", lastAnna);
+    printResult("field scoped", book.findQuery(lastAnna).empty(), true);
+
+    ContactQuery phoneType;
+    ContactQuery::parse("phone:1000037 type:work", phoneType);
+    printResult("type limits phone", book.findQuery(phoneType) == std::vector<std::size_t>{ 1 }, true);
+    ContactQuery::parse("phone:1000037 type:home", phoneType);
+    printResult("type limits phone (other type)", book.findQuery(phoneType).empty(), true);
+
+    // самый избирательный индекс идёт первым
+    ContactQuery mixed;
+    ContactQuery::parse("last:ров born:1973-04-04", mixed);
+    const QueryPlan plan = book.planQuery(mixed);
+    printResult("selective index first",
+                plan.steps.size() == 2 && plan.steps[0].access == QueryPlan::Access::BirthDate
+                    && plan.steps[0].estimate == 1, true);
+    printResult("no index without search index", scan.planQuery(mixed).steps.empty(), true);
+}
+
+void testParallelSearch()
+{
+    std::cout << "\n=== TEST PARALLEL SEARCH ===\n";
+
+    ContactBook book;
+    book.setSearchIndex(false);
+    const char* lastNames[] = { "Иванов", "Петров", "Сидорова", "Smith", "Кузнецов" };
+    for (int i = 0; i < 3000; ++i)
+    {
+        Contact c(lastNames[i % 5] + std::to_string(i % 97), i % 3 ? "Анна" : "Пётр", "",
+                  "ул. Мира, д. " + std::to_string(i), Date(1990, 1, 1), "user" + std::to_string(i) + "@mail.ru");
+        c.addPhone(PhoneNumber("+7(812)" + std::to_string(1000000 + i * 37), PhoneType::Home));
+        book.addContact(c);
+    }
+
+    // части буфера на стыках не должны терять и дублировать совпадения
+    const char* needles[] = { "и", "ов1", "смит", "smith4", "@mail", "мира, д. 29", "812100", "нет такого", "ru" };
+    bool same = true;
+    for (const char* needle : needles)
+    {
+        book.setSearchThreads(1);
+        const std::vector<std::size_t> sequential = book.find(needle);
+        for (unsigned threads : { 2u, 3u, 7u })
+        {
+            book.setSearchThreads(threads);
+            same = same && book.find(needle) == sequential;
+        }
+    }
+    printResult("threads match sequential", same, true);
+
+    std::atomic<bool> cancel{false};
+    std::vector<std::size_t> out;
+    book.setSearchThreads(4);
+    printResult("not cancelled finds", book.find("иванов1", out, cancel) && out == book.find("иванов1"), true);
+
+    cancel = true;
+    printResult("cancelled stops", book.find("иванов1", out, cancel), false);
+    printResult("cancelled result empty", out.empty(), true);
+
+    // отмена посреди перестройки индекса и буфера ключей не портит их
+    book.addContact(Contact("Иванов1", "Анна", "", "", Date(1990, 1, 1), ""));
+    printResult("cancelled key rebuild", book.find("иванов1", out, cancel), false);
+    book.setSearchIndex(true);
+    printResult("cancelled index build", book.find("иванов1", out, cancel), false);
+    std::vector<std::size_t> indexed = book.find("иванов1");
+    book.setSearchIndex(false);
+    printResult("rebuilt after cancel", indexed == book.find("иванов1") && indexed.back() == 3000, true);
+
+    // строка поиска окна: отменённый запрос не попадает в стопку
+    IncrementalSearch search(book);
+    printResult("needs full search", search.needsFullSearch("иванов1"), true);
+    printResult("cancelled incremental", search.search("иванов1", cancel) == nullptr, true);
+    printResult("still needs full search", search.needsFullSearch("иванов1"), true);
+
+    cancel = false;
+    const std::vector<std::size_t>* found = search.search("иванов1", cancel);
+    printResult("incremental matches find", found && *found == book.find("иванов1"), true);
+    printResult("next letter refines", search.needsFullSearch("иванов12"), false);
+}
+
+void testTranslit()
+{
+    std::cout << "\n=== TEST TRANSLIT ===\n";
+
+    // разные системы транслитерации дают один ключ
+    printResult("Ivanov = Иванов", Translit::key("Ivanov") == Translit::key("Иванов"), true);
+    printResult("Shchukin = Щукин", Translit::key("Shchukin") == Translit::key("Щукин"), true);
+    printResult("Schukin = Щукин", Translit::key("Schukin") == Translit::key("Щукин"), true);
+    printResult("Yuriy = Юрий", Translit::key("Yuriy") == Translit::key("Юрий"), true);
+    printResult("Yury = Юрий", Translit::key("Yury") == Translit::key("Юрий"), true);
+    printResult("Tsoy = Цой", Translit::key("Tsoy") == Translit::key("Цой"), true);
+    printResult("Khodorov = Ходоров", Translit::key("Khodorov") == Translit::key("Ходоров"), true);
+    printResult("Smith = Смит", Translit::key("Smith") == Translit::key("Смит"), true);
+    printResult("Fyodor = Фёдор", Translit::key("Fyodor") == Translit::key("Фёдор")
+                                      && Translit::key("Fedor") == Translit::key("Фёдор"), true);
+    printResult("Yolkin = Ёлкин", Translit::key("Yolkin") == Translit::key("Ёлкин"), true);
+    printResult("Yevgeny = Евгений", Translit::key("Yevgeny") == Translit::key("Евгений")
+                                         && Translit::key("Evgeny") == Translit::key("Евгений"), true);
+    printResult("Vorobyov = Воробьёв", Translit::key("Vorobyov") == Translit::key("Воробьёв"), true);
+    printResult("soft sign dropped", Translit::key("Игорь") == "igor", true);
+    printResult("other chars kept", Translit::key("ул. Мира, 5") == "ul. mira, 5", true);
+    printResult("double letters kept", Translit::key("Анна") == "anna" && Translit::key("Anna") == "anna", true);
+    printResult("script", Translit::script("Ivanov") == Translit::Script::Latin
+                              && Translit::script("Ivan Петров") == Translit::Script::Cyrillic
+                              && Translit::script("+7 812") == Translit::Script::None, true);
+
+    ContactBook book;
+    book.addContact(Contact("Иванов", "Юрий", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Petrov", "Ivan", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Щукин", "Пётр", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Tsoy", "Viktor", "", "", Date(1990, 1, 1), ""));
+    book.addContact(Contact("Сидоров", "Олег", "", "Ivanovo", Date(1990, 1, 1), ""));
+
+    printResult("Latin finds Cyrillic", book.find("Ivanov") == std::vector<std::size_t>{ 0, 4 }, true);
+    printResult("Cyrillic finds Latin", book.find("Петров") == std::vector<std::size_t>{ 1 }, true);
+    printResult("other spelling", book.find("Yury") == std::vector<std::size_t>{ 0 }, true);
+    printResult("shch", book.find("shchuk") == std::vector<std::size_t>{ 2 }, true);
+    printResult("Цой by Latin record", book.find("цой") == std::vector<std::size_t>{ 3 }, true);
+    printResult("yo spelling", book.find("Pyotr") == std::vector<std::size_t>{ 2 }, true);
+    printResult("no false match", book.find("Sidorova").empty(), true);
+
+    // внутри одного письма транслитерация не подмешивается: «Анна» — не «Светлана»,
+    // «Бил» — не «Былов»; в другом письме — находится
+    {
+        ContactBook names;
+        names.addContact(Contact("Смирнова", "Анна", "", "", Date(1990, 1, 1), ""));
+        names.addContact(Contact("Орлова", "Светлана", "", "", Date(1990, 1, 1), ""));
+        names.addContact(Contact("Былов", "Олег", "", "", Date(1990, 1, 1), ""));
+        names.addContact(Contact("Smith", "Anna", "", "", Date(1990, 1, 1), ""));
+        names.addContact(Contact("Brown", "Diana", "", "", Date(1990, 1, 1), ""));
+        printResult("Анна is not Светлана", names.find("Анна") == std::vector<std::size_t>{ 0, 3 }, true);
+        printResult("Anna is not Diana", names.find("Anna") == std::vector<std::size_t>{ 0, 3 }, true);
+        printResult("same script exact", names.find("Бил").empty(), true);
+        names.setSearchIndex(false);
+        printResult("Анна without index", names.find("Анна") == std::vector<std::size_t>{ 0, 3 }, true);
+    }
+
+    // в запросе по полям — только своё поле ФИО
+    ContactQuery query;
+    ContactQuery::parse("last:Ivanov", query);
+    printResult("last:Ivanov", book.findQuery(query) == std::vector<std::size_t>{ 0 }, true);
+    ContactQuery::parse("first:Иван", query);
+    printResult("first:Иван", book.findQuery(query) == std::vector<std::size_t>{ 1 }, true);
+    ContactQuery::parse("address:Иваново", query);
+    printResult("address not transliterated", book.findQuery(query).empty(), true);
+
+    // ввод по буквам латиницей: «sc» ещё не «щ», «sch» — уже он
+    IncrementalSearch search(book);
+    bool same = true;
+    std::string typed;
+    for (const char* letter : { "s", "c", "h", "u", "k" })
+    {
+        typed += letter;
+        same = same && search.search(typed) == book.find(typed);
+    }
+    printResult("typing Latin matches find", same, true);
+    printResult("typed finds Щукин", book.find(typed) == std::vector<std::size_t>{ 2 }, true);
+
+    // кириллицей по латинице: ключ «p» → «pe» → «pet» продолжается, результат сужается
+    same = true;
+    bool refined = true;
+    typed.clear();
+    for (const char* letter : { "п", "е", "т", "р", "о" })
+    {
+        typed += letter;
+        same = same && search.search(typed) == book.find(typed);
+        refined = refined && (typed == "п" || search.lastStep() == IncrementalSearch::Step::Refined);
+    }
+    printResult("typing Cyrillic matches find", same && refined, true);
+    printResult("typed finds Petrov", book.find(typed) == std::vector<std::size_t>{ 1 }, true);
+
+    // без индекса — тот же результат просмотром буфера
+    const std::vector<std::size_t> indexed = book.find("Ivanov");
+    book.setSearchIndex(false);
+    printResult("scan equals index", book.find("Ivanov") == indexed, true);
+    book.setSearchIndex(true);
+
+    // ключи следуют за изменениями
+    book.addContact(Contact("Жуков", "Илья", "", "", Date(1990, 1, 1), ""));
+    printResult("added contact by Latin", book.find("Zhukov") == std::vector<std::size_t>{ 5 }, true);
+    book.removeContact(std::size_t(0));
+    printResult("removed contact gone", book.find("Ivanov") == std::vector<std::size_t>{ 4 }, true);
+}
+
 int main()
 {
     testNames();
     testPhones();
     testEmails();
     testDates();
+    testDateFormat();
     testContactBookRoundTrip();
+    testSnapshotRoundTrip();
+    testJournalReplay();
+    testBlockStore();
+    testImport();
+    testExport();
+    testStringInterning();
+    testContactStore();
+    testInlinePhones();
+    testPhoneCanonical();
+    testContactHandles();
+    testBulkChanges();
+    testSearchIndex();
+    testCaseFolding();
+    testPhoneDigits();
+    testIncrementalSearch();
+    testSubstringScan();
+    testFuzzySearch();
+    testContactQuery();
+    testParallelSearch();
+    testTranslit();
 
     std::cout << "\n=== TESTS FINISHED ===\n";
     return 0;